@@ -11,15 +11,40 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = Sudoku
 TEMPLATE = app
 
+CONFIG += c++11
+
 
 SOURCES += main.cpp\
         mainwindow.cpp \
+    solverthread.cpp \
     src/Sudoku.cpp \
-    src/SudokuSolver.cpp
+    src/GridValidator.cpp \
+    src/CandidateEngine.cpp \
+    src/SudokuSolver.cpp \
+    src/CancelToken.cpp \
+    src/BitmaskSolver.cpp \
+    src/BatchSolver.cpp \
+    src/ParallelSolver.cpp \
+    src/Canonicalizer.cpp \
+    src/CachingSolver.cpp \
+    src/GridFile.cpp \
+    src/SolutionStore.cpp
 
 HEADERS  += mainwindow.h \
+    solverthread.h \
     src/Sudoku.hpp \
-    src/SudokuSolver.hpp
+    src/GridValidator.hpp \
+    src/CandidateEngine.hpp \
+    src/SudokuSolver.hpp \
+    src/SearchStats.hpp \
+    src/CancelToken.hpp \
+    src/BitmaskSolver.hpp \
+    src/BatchSolver.hpp \
+    src/ParallelSolver.hpp \
+    src/Canonicalizer.hpp \
+    src/CachingSolver.hpp \
+    src/GridFile.hpp \
+    src/SolutionStore.hpp
 
 FORMS    += mainwindow.ui
 
@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# Solver benchmarks, no Qt dependency.
+#
+#-------------------------------------------------
+
+TARGET = sudoku-bench
+TEMPLATE = app
+
+CONFIG += console c++11 thread release
+CONFIG -= qt app_bundle
+
+SOURCES += bench/main.cpp \
+    bench/Corpus.cpp \
+    bench/PhaseSolver.cpp \
+    bench/CacheCounters.cpp \
+    src/Sudoku.cpp \
+    src/GridValidator.cpp \
+    src/SudokuSolver.cpp \
+    src/CancelToken.cpp \
+    src/BitmaskSolver.cpp \
+    src/BatchSolver.cpp \
+    src/ParallelSolver.cpp \
+    src/Canonicalizer.cpp \
+    src/CachingSolver.cpp \
+    src/Random.cpp \
+    src/Generator.cpp
+
+HEADERS += bench/Corpus.hpp \
+    bench/PhaseSolver.hpp \
+    bench/CacheCounters.hpp \
+    src/Sudoku.hpp \
+    src/GridValidator.hpp \
+    src/SudokuSolver.hpp \
+    src/SearchStats.hpp \
+    src/CancelToken.hpp \
+    src/BitmaskSolver.hpp \
+    src/BatchSolver.hpp \
+    src/ParallelSolver.hpp \
+    src/Canonicalizer.hpp \
+    src/CachingSolver.hpp \
+    src/Random.hpp \
+    src/Generator.hpp
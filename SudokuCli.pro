@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# Headless batch solver, no Qt dependency.
+#
+#-------------------------------------------------
+
+TARGET = sudoku-cli
+TEMPLATE = app
+
+CONFIG += console c++11 thread
+CONFIG -= qt app_bundle
+
+SOURCES += cli/main.cpp \
+    cli/BatchRunner.cpp \
+    src/Sudoku.cpp \
+    src/GridValidator.cpp \
+    src/SudokuSolver.cpp \
+    src/CancelToken.cpp \
+    src/BitmaskSolver.cpp \
+    src/BatchSolver.cpp \
+    src/ParallelSolver.cpp \
+    src/Canonicalizer.cpp \
+    src/CachingSolver.cpp \
+    src/GridFile.cpp \
+    src/SolutionStore.cpp \
+    src/Random.cpp \
+    src/Generator.cpp
+
+HEADERS += cli/BatchRunner.hpp \
+    src/Sudoku.hpp \
+    src/GridValidator.hpp \
+    src/SudokuSolver.hpp \
+    src/SearchStats.hpp \
+    src/CancelToken.hpp \
+    src/BitmaskSolver.hpp \
+    src/BatchSolver.hpp \
+    src/ParallelSolver.hpp \
+    src/Canonicalizer.hpp \
+    src/CachingSolver.hpp \
+    src/GridFile.hpp \
+    src/SolutionStore.hpp \
+    src/Random.hpp \
+    src/Generator.hpp
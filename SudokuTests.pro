@@ -0,0 +1,51 @@
+#-------------------------------------------------
+#
+# Unit tests, no Qt dependency.
+#
+#-------------------------------------------------
+
+TARGET = sudoku-tests
+TEMPLATE = app
+
+CONFIG += console c++11 thread
+CONFIG -= qt app_bundle
+
+SOURCES += tests/main.cpp \
+    tests/SudokuParseTest.cpp \
+    tests/GridValidatorTest.cpp \
+    tests/CandidateEngineTest.cpp \
+    tests/SolutionStoreTest.cpp \
+    tests/CanonicalizerTest.cpp \
+    tests/GridFileTest.cpp \
+    tests/GeneratorTest.cpp \
+    src/Sudoku.cpp \
+    src/GridValidator.cpp \
+    src/CandidateEngine.cpp \
+    src/SudokuSolver.cpp \
+    src/CancelToken.cpp \
+    src/BitmaskSolver.cpp \
+    src/BatchSolver.cpp \
+    src/ParallelSolver.cpp \
+    src/Canonicalizer.cpp \
+    src/CachingSolver.cpp \
+    src/GridFile.cpp \
+    src/SolutionStore.cpp \
+    src/Random.cpp \
+    src/Generator.cpp
+
+HEADERS += tests/Check.hpp \
+    src/Sudoku.hpp \
+    src/GridValidator.hpp \
+    src/CandidateEngine.hpp \
+    src/SudokuSolver.hpp \
+    src/SearchStats.hpp \
+    src/CancelToken.hpp \
+    src/BitmaskSolver.hpp \
+    src/BatchSolver.hpp \
+    src/ParallelSolver.hpp \
+    src/Canonicalizer.hpp \
+    src/CachingSolver.hpp \
+    src/GridFile.hpp \
+    src/SolutionStore.hpp \
+    src/Random.hpp \
+    src/Generator.hpp
@@ -0,0 +1,105 @@
+//! \file
+//! \brief CacheCounters implementation.
+//! \author Mathieu Turcotte
+
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "CacheCounters.hpp"
+
+namespace {
+
+#if defined(__linux__)
+//! \brief Open a user space counter of the calling thread.
+//! \return The counter file descriptor, -1 on failure.
+int open_counter(unsigned int type, unsigned long long config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+} // namespace
+
+CacheCounters::CacheCounters(): l1d_fd(-1), llc_fd(-1) {
+#if defined(__linux__)
+    l1d_fd = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    llc_fd = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+
+    // Report both or none.
+    if (l1d_fd < 0 || llc_fd < 0) {
+        if (l1d_fd >= 0)
+            close(l1d_fd);
+        if (llc_fd >= 0)
+            close(llc_fd);
+        l1d_fd = llc_fd = -1;
+    }
+#endif
+}
+
+CacheCounters::~CacheCounters() {
+#if defined(__linux__)
+    if (available()) {
+        close(l1d_fd);
+        close(llc_fd);
+    }
+#endif
+}
+
+bool CacheCounters::available() const {
+    return l1d_fd >= 0;
+}
+
+void CacheCounters::start() {
+#if defined(__linux__)
+    if (!available())
+        return;
+    ioctl(l1d_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(llc_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(l1d_fd, PERF_EVENT_IOC_ENABLE, 0);
+    ioctl(llc_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+void CacheCounters::stop() {
+#if defined(__linux__)
+    if (!available())
+        return;
+    ioctl(l1d_fd, PERF_EVENT_IOC_DISABLE, 0);
+    ioctl(llc_fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+}
+
+unsigned long long CacheCounters::l1d_misses() const {
+    return read(l1d_fd);
+}
+
+unsigned long long CacheCounters::llc_misses() const {
+    return read(llc_fd);
+}
+
+unsigned long long CacheCounters::read(int fd) const {
+    unsigned long long value = 0;
+#if defined(__linux__)
+    if (fd >= 0 && ::read(fd, &value, sizeof(value)) != sizeof(value))
+        value = 0;
+#else
+    (void) fd;
+#endif
+    return value;
+}
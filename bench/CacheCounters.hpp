@@ -0,0 +1,49 @@
+//! \file
+//! \brief CacheCounters interface.
+//! \author Mathieu Turcotte
+
+#ifndef CACHE_COUNTERS_H_
+#define CACHE_COUNTERS_H_
+
+//! \brief Hardware cache miss counters.
+//!
+//! On Linux, the counters are opened with perf_event_open for the calling
+//! thread and the threads it starts afterwards, user space only. They are
+//! unavailable elsewhere, on machines without a performance monitoring
+//! unit (most virtual machines) or when perf_event_paranoid forbids them.
+class CacheCounters {
+public:
+    //! \brief CacheCounters constructor, opening the counters.
+    CacheCounters();
+
+    //! \brief CacheCounters destructor, closing the counters.
+    ~CacheCounters();
+
+    CacheCounters(const CacheCounters&) = delete;
+    CacheCounters& operator=(const CacheCounters&) = delete;
+
+    //! \brief Query whether the counters could be opened.
+    //! \return False if start and stop do nothing.
+    bool available() const;
+
+    //! \brief Reset the counters and start counting.
+    void start();
+
+    //! \brief Stop counting.
+    void stop();
+
+    //! \brief Get the level 1 data cache read misses counted.
+    unsigned long long l1d_misses() const;
+
+    //! \brief Get the last level cache misses counted.
+    unsigned long long llc_misses() const;
+
+protected:
+    //! \brief Read a counter.
+    unsigned long long read(int fd) const;
+
+    int l1d_fd;     /**< L1 data cache read misses counter, -1 if unavailable. */
+    int llc_fd;     /**< Last level cache misses counter, -1 if unavailable. */
+};
+
+#endif // CACHE_COUNTERS_H_
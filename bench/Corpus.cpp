@@ -0,0 +1,84 @@
+//! \file
+//! \brief Benchmark corpora implementation.
+//! \author Mathieu Turcotte
+
+#include "Corpus.hpp"
+#include "../src/Generator.hpp"
+#include "../src/Random.hpp"
+
+namespace {
+
+//! \brief Known 17-clue puzzles, the seeds of the 17-clue corpus.
+const char* const seventeen_clues[] = {
+    "xxxxxxx0x3xxxxxxxxx1xxxxxxxxxxx4x3x6xx7xxx2xxxx0x8xxxx2xx3xx1xxx4x0xxxxxxxx7x5xxx",
+    "xxxxxxx0x3xxxxxxxxx1xxxxxxxxxxx4x5x3xx7xxx2xxxx0x8xxxx2xx3xx1xxx4x0xxxxxxxx7x6xxx",
+    "xxxxxxx01xxxx24xxxxxx5xxx6x6xxxxx2xxxxx3xx7xx0xxxxxxxxxxx01xxxxx7xxxxx3xx4xxxx5xx",
+    "xxxxxxx01xx25xxxxxxxxxx6xxx30xx1xxxxxxx4xx2xx6xxxxx5xx17xxxxx3xxxx2xx4xxxxxxxxxxx",
+    "xxxxxxx01xx7x2xxxxxxxxxxx3x01x4xxxxxxxxxx36xxx5xxxxxxx4x6xxx2xxxxx51xxxxxxx0xxxxx",
+    "xxxxxxx01x3xx4xxxxxxxxx8xxxx6x5xx3xxxxx0xxxxxxxxxxxx4xxxxx764xx5x0xxx2xx1xxxxxxxx",
+    "xxxxxxx01x4x3xxxxxxxxxxxx2x6xx5xx3xxxx0xxxxxxxxxx7xxxx81xxxx7xxxxx40x6xxxxxxx2xxx",
+    "xxxxxxx012xxxxxx5xxxxx3xxxx8xxxxx4xxxxxxx0x6xx1xxxxxxxxxx24x3xxxx03xx7xxx5xxxxxxx",
+    "xxxxxxx013xxx8xxxxxxxxxxx4xx6x1xxxxx5xxxxx3xxxxx0x7xxxx07xxxxxxxxxx2x6xx4x1xxxxxx",
+    "xxxxxxx014xxxx7xxxxxx6xxxxx5xx01xxxx6xxxxx34xxxxx2xxxxx2xxxx7xxxxx4xx6xxx1xxxxxxx",
+    "xxxxxxx02xxxx2xx7xx6xxxxxxxxxx1x5xxxx2xxxx8xxxxxx0xxxx5xx4xx1x3xxx3xx6xx0xxxxxxxx",
+    "xxxxxxx02xxx1xxxxxxxxxxxx7xxxx65x1xxxx7xxx3xxx0xxxxxxx1xxxxx64x5xx23xxxxxxxxx7xxx",
+    "xxxxxxx02xxx4xxx6xxxx7x1xxxxxx3xx8xx0x6xxxxxxxxxxxx1xx78xxxxx4xx3xxxx5xxxxxx0xxxx"
+};
+
+const std::size_t num_seventeen_clues =
+        sizeof(seventeen_clues) / sizeof(seventeen_clues[0]);
+
+} // namespace
+
+const char* corpus_name(CorpusKind kind) {
+    switch (kind) {
+    case corpus_easy: return "easy";
+    case corpus_hard: return "hard";
+    case corpus_17_clue: return "17-clue";
+    case corpus_16x16: return "16x16";
+    case corpus_25x25: return "25x25";
+    default: return "unknown";
+    }
+}
+
+Corpus make_corpus(CorpusKind kind, std::size_t count, unsigned long seed) {
+    Corpus corpus;
+    corpus.name = corpus_name(kind);
+
+    // Each kind has its own sequence, whichever kinds are generated.
+    unsigned long kind_seed = seed * num_corpus_kinds + kind;
+
+    if (kind == corpus_17_clue) {
+        corpus.puzzles.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            Random random(kind_seed, i);
+            corpus.puzzles.push_back(shuffle(
+                    Sudoku(seventeen_clues[i % num_seventeen_clues]), random));
+        }
+        return corpus;
+    }
+
+    GeneratorOptions options = { 3, 3, kind_seed, 0, symmetry_none, 0 };
+    switch (kind) {
+    case corpus_easy:
+        options.num_clues = 36;
+        break;
+    case corpus_hard:
+        break;
+    case corpus_16x16:
+        options.region_num_row = options.region_num_col = 4;
+        options.num_clues = 256 - 256 * 45 / 100;
+        break;
+    case corpus_25x25:
+        options.region_num_row = options.region_num_col = 5;
+        options.num_clues = 625 - 625 * 35 / 100;
+        break;
+    default:
+        return corpus;
+    }
+
+    PuzzleGenerator generator(options);
+    corpus.puzzles.resize(count, Sudoku(options.region_num_row, options.region_num_col));
+    generator.generate(0, corpus.puzzles.data(), count);
+    return corpus;
+}
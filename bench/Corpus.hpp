@@ -0,0 +1,47 @@
+//! \file
+//! \brief Benchmark corpora interface.
+//! \author Mathieu Turcotte
+
+#ifndef CORPUS_H_
+#define CORPUS_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../src/Sudoku.hpp"
+
+//! \brief Kinds of benchmark corpora.
+enum CorpusKind {
+    corpus_easy,        /**< 9x9 grids with 36 clues and a unique solution. */
+    corpus_hard,        /**< Minimal 9x9 grids: no clue can be removed. */
+    corpus_17_clue,     /**< 9x9 grids with 17 clues, the fewest possible. */
+    corpus_16x16,       /**< 16x16 grids with 45% of blanks. */
+    corpus_25x25,       /**< 25x25 grids with 35% of blanks. */
+    num_corpus_kinds    /**< Number of corpus kinds. */
+};
+
+//! \brief A set of puzzles of the same kind.
+struct Corpus {
+    std::string name;               /**< Corpus name. */
+    std::vector<Sudoku> puzzles;    /**< The puzzles. */
+};
+
+//! \brief Get the name of a corpus kind.
+//! \param kind A corpus kind.
+//! \return "easy", "hard", "17-clue", "16x16" or "25x25".
+const char* corpus_name(CorpusKind kind);
+
+//! \brief Generate a corpus.
+//! \param kind The kind of puzzles.
+//! \param count The number of puzzles.
+//! \param seed The generator seed, a given seed always gives the
+//!             same puzzles.
+//! \return The corpus.
+//!
+//! Puzzles come from PuzzleGenerator, on every core. The 17-clue
+//! puzzles are shuffled from a few known ones, since removing clues at
+//! random never gets that low.
+Corpus make_corpus(CorpusKind kind, std::size_t count, unsigned long seed);
+
+#endif // CORPUS_H_
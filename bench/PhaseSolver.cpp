@@ -0,0 +1,44 @@
+//! \file
+//! \brief PhaseSolver implementation.
+//! \author Mathieu Turcotte
+
+#include <chrono>
+#include <memory>
+#include <limits>
+
+#include "PhaseSolver.hpp"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+bool PhaseSolver::solve(Sudoku& s, PhaseTimes& times) {
+    Clock::time_point start = Clock::now();
+    std::unique_ptr<CoverMatrix> cm(new CoverMatrix());
+    build_cover_matrix(*cm, s);
+    times.build = seconds_since(start);
+
+    start = Clock::now();
+    bool solved = apply_givens(*cm, s);
+    if (solved) {
+        reset_search(*cm);
+        unsigned long budget = std::numeric_limits<unsigned long>::max();
+        solved = search(budget) == search_solved;
+        if (solved)
+            write_solution(s);
+        unwind_search();
+    }
+    remove_givens(*cm);
+    times.search = seconds_since(start);
+
+    start = Clock::now();
+    cm.reset();
+    times.destroy = seconds_since(start);
+    return solved;
+}
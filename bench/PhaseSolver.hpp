@@ -0,0 +1,31 @@
+//! \file
+//! \brief Dancing links solver timing each phase of a solve.
+//! \author Mathieu Turcotte
+
+#ifndef PHASE_SOLVER_H_
+#define PHASE_SOLVER_H_
+
+#include "../src/SudokuSolver.hpp"
+
+//! \brief Duration of the phases of a solve, in seconds.
+struct PhaseTimes {
+    double build;   /**< Building the cover matrix. */
+    double search;  /**< Applying the grid values and searching. */
+    double destroy; /**< Releasing the cover matrix. */
+};
+
+//! \brief Dancing links solver building a new cover matrix for each grid.
+//!
+//! DancingLinksSolver keeps its cover matrices between solves. This one
+//! builds and releases a matrix around each search so that the three
+//! phases can be timed separately.
+class PhaseSolver: public DancingLinksSolver {
+public:
+    //! \brief Solve a sudoku grid, timing each phase.
+    //! \param[out] s The sudoku grid to solve.
+    //! \param[out] times The duration of each phase.
+    //! \return True if the grid was solved, false otherwise.
+    bool solve(Sudoku& s, PhaseTimes& times);
+};
+
+#endif // PHASE_SOLVER_H_
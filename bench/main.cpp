@@ -0,0 +1,302 @@
+//! \file
+//! \brief Solver benchmarks.
+//! \author Mathieu Turcotte
+//!
+//! Generates the benchmark corpora from a fixed seed, solves each of them
+//! with every solver and writes one result per corpus and solver, as CSV
+//! or JSON, on the standard output. Each result gives the throughput and
+//! the p50, p99 and max latency of a single solve. The "dlx-phases" rows
+//! time the cover matrix build, the search and the matrix release of a
+//! dancing links solve separately (see PhaseSolver). The "dlx-cached" rows
+//! also write their cache hit rate on the standard error. Where the
+//! hardware counters are available (see CacheCounters), each result also
+//! gives the L1 data and last level cache misses per puzzle.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>    // std::sort
+#include <cstdlib>
+#include <cstring>
+
+#include "Corpus.hpp"
+#include "PhaseSolver.hpp"
+#include "CacheCounters.hpp"
+#include "../src/SudokuSolver.hpp"
+#include "../src/BatchSolver.hpp"
+#include "../src/BitmaskSolver.hpp"
+#include "../src/CachingSolver.hpp"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+//! \brief Benchmark options.
+struct Options {
+    std::size_t count;          /**< Number of 9x9 puzzles per corpus. */
+    unsigned long seed;         /**< Corpus generator seed. */
+    bool json;                  /**< Write JSON rather than CSV. */
+    std::string solver;         /**< Only run this solver, all if empty. */
+    std::string corpus;         /**< Only run this corpus, all if empty. */
+};
+
+//! \brief Result of a solver on a corpus.
+struct Result {
+    std::string corpus;         /**< Corpus name. */
+    std::string solver;         /**< Solver name. */
+    std::size_t num_puzzles;    /**< Number of puzzles. */
+    std::size_t num_solved;     /**< Number of puzzles solved. */
+    double puzzles_per_s;       /**< Throughput. */
+    double p50_us;              /**< Median solve latency. */
+    double p99_us;              /**< 99th percentile solve latency. */
+    double max_us;              /**< Worst solve latency. */
+    bool has_phases;            /**< True if the phase means are set. */
+    double build_us;            /**< Mean cover matrix build time. */
+    double search_us;           /**< Mean search time. */
+    double destroy_us;          /**< Mean cover matrix release time. */
+    bool has_misses;            /**< True if the cache miss means are set. */
+    double l1d_misses;          /**< Mean L1 data cache read misses per puzzle. */
+    double llc_misses;          /**< Mean last level cache misses per puzzle. */
+};
+
+const char* const solver_names[] = { "dlx", "dlx-parallel", "dlx-cached", "bitmask",
+                                      "bitmask-generic", "batch" };
+
+//! \brief Create a solver, bitmask-generic being the bitmask solver
+//!        without its per geometry instantiations.
+SudokuSolver* create_solver(const std::string& name) {
+    if (name == "bitmask-generic")
+        return new BitmaskSolver(false);
+    return SudokuSolver::create(name);
+}
+
+void usage(const char* program) {
+    std::cerr << "Usage: " << program << " [-n count] [-g seed] [-f csv|json] [-s solver] [-k corpus]\n"
+              << "  -n count    number of 9x9 puzzles per corpus (default: 100), a\n"
+              << "              quarter as many 16x16 and a tenth as many 25x25\n"
+              << "  -g seed     corpus generator seed (default: 1)\n"
+              << "  -f format   output format, csv (default) or json\n"
+              << "  -s solver   only run dlx, dlx-phases, dlx-parallel, dlx-cached,\n"
+              << "              bitmask, bitmask-generic or batch\n"
+              << "  -k corpus   only run easy, hard, 17-clue, 16x16 or 25x25\n";
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    options.count = 100;
+    options.seed = 1;
+    options.json = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i + 1 >= argc)
+            return false;
+        const char* value = argv[++i];
+        switch (arg[1]) {
+        case 'n': options.count = std::strtoul(value, 0, 10); break;
+        case 'g': options.seed = std::strtoul(value, 0, 10); break;
+        case 'f':
+            if (std::strcmp(value, "json") != 0 && std::strcmp(value, "csv") != 0)
+                return false;
+            options.json = std::strcmp(value, "json") == 0;
+            break;
+        case 's': options.solver = value; break;
+        case 'k': options.corpus = value; break;
+        default: return false;
+        }
+    }
+    return options.count > 0;
+}
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+//! \brief Fill the latency fields of a result.
+//! \param[in,out] latencies The latency of each solve, in seconds, sorted.
+void set_latencies(Result& result, std::vector<double>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    std::size_t n = latencies.size();
+    result.p50_us = latencies[(n - 1) / 2] * 1e6;
+    result.p99_us = latencies[(n - 1) * 99 / 100] * 1e6;
+    result.max_us = latencies[n - 1] * 1e6;
+}
+
+//! \brief Fill the cache miss fields of a result, if the counters are
+//!        available.
+void set_misses(Result& result, const CacheCounters& counters) {
+    if (!counters.available())
+        return;
+    result.has_misses = true;
+    result.l1d_misses = static_cast<double>(counters.l1d_misses()) / result.num_puzzles;
+    result.llc_misses = static_cast<double>(counters.llc_misses()) / result.num_puzzles;
+}
+
+//! \brief Solve every puzzle of a corpus, one at a time.
+Result run_solver(const Corpus& corpus, const std::string& name) {
+    Result result = { corpus.name, name, corpus.puzzles.size(), 0, 0, 0, 0, 0,
+                      false, 0, 0, 0, false, 0, 0 };
+    std::unique_ptr<SudokuSolver> solver(create_solver(name));
+    std::vector<double> latencies;
+    latencies.reserve(corpus.puzzles.size());
+
+    // Warm up: the solvers keep per geometry state between solves.
+    Sudoku warm_up(corpus.puzzles[0]);
+    solver->solve(warm_up);
+
+    CacheCounters counters;
+    counters.start();
+    double total = 0;
+    for (std::size_t i = 0; i < corpus.puzzles.size(); ++i) {
+        Sudoku s(corpus.puzzles[i]);
+        Clock::time_point start = Clock::now();
+        result.num_solved += solver->solve(s);
+        latencies.push_back(seconds_since(start));
+        total += latencies.back();
+    }
+    counters.stop();
+    set_misses(result, counters);
+
+    // The batch solver is meant to get many grids at once, its
+    // throughput is measured that way.
+    if (BatchSolver* batch = dynamic_cast<BatchSolver*>(solver.get())) {
+        std::vector<Sudoku> grids(corpus.puzzles);
+        Clock::time_point start = Clock::now();
+        batch->solve_batch(&grids[0], grids.size());
+        total = seconds_since(start);
+    }
+
+    // The cache counters don't fit the table, they go with the progress.
+    if (CachingSolver* cached = dynamic_cast<CachingSolver*>(solver.get())) {
+        const CacheStats& stats = cached->cache_stats();
+        unsigned long long lookups = stats.hits + stats.misses + stats.skipped;
+        std::cerr << name << " on " << corpus.name << ": " << stats.hit_rate() * 100
+                  << "% hit rate, " << stats.skipped << " skipped, "
+                  << (lookups ? stats.lookup_seconds / lookups * 1e6 : 0)
+                  << " us per lookup, " << stats.memory_bytes << " bytes" << std::endl;
+    }
+
+    result.puzzles_per_s = total > 0 ? corpus.puzzles.size() / total : 0;
+    set_latencies(result, latencies);
+    return result;
+}
+
+//! \brief Solve every puzzle of a corpus, timing the phases of each solve.
+Result run_phases(const Corpus& corpus) {
+    Result result = { corpus.name, "dlx-phases", corpus.puzzles.size(), 0, 0, 0, 0, 0,
+                      true, 0, 0, 0, false, 0, 0 };
+    PhaseSolver solver;
+    std::vector<double> latencies;
+    latencies.reserve(corpus.puzzles.size());
+
+    CacheCounters counters;
+    counters.start();
+    double total = 0;
+    for (std::size_t i = 0; i < corpus.puzzles.size(); ++i) {
+        Sudoku s(corpus.puzzles[i]);
+        PhaseTimes times;
+        result.num_solved += solver.solve(s, times);
+        latencies.push_back(times.build + times.search + times.destroy);
+        total += latencies.back();
+        result.build_us += times.build;
+        result.search_us += times.search;
+        result.destroy_us += times.destroy;
+    }
+    counters.stop();
+    set_misses(result, counters);
+
+    std::size_t n = corpus.puzzles.size();
+    result.build_us *= 1e6 / n;
+    result.search_us *= 1e6 / n;
+    result.destroy_us *= 1e6 / n;
+    result.puzzles_per_s = total > 0 ? n / total : 0;
+    set_latencies(result, latencies);
+    return result;
+}
+
+void write_csv(std::ostream& out, const std::vector<Result>& results) {
+    out << "corpus,solver,puzzles,solved,puzzles_per_s,p50_us,p99_us,max_us,"
+           "build_us,search_us,destroy_us,l1d_misses,llc_misses\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << r.corpus << ',' << r.solver << ',' << r.num_puzzles << ','
+            << r.num_solved << ',' << r.puzzles_per_s << ',' << r.p50_us << ','
+            << r.p99_us << ',' << r.max_us << ',';
+        if (r.has_phases)
+            out << r.build_us << ',' << r.search_us << ',' << r.destroy_us;
+        else
+            out << ",,";
+        out << ',';
+        if (r.has_misses)
+            out << r.l1d_misses << ',' << r.llc_misses;
+        else
+            out << ',';
+        out << '\n';
+    }
+}
+
+void write_json(std::ostream& out, const Options& options,
+                const std::vector<Result>& results) {
+    out << "{\n  \"seed\": " << options.seed << ",\n  \"count\": " << options.count
+        << ",\n  \"kernel\": \"" << BatchSolver::kernel() << "\",\n  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"corpus\": \"" << r.corpus
+            << "\", \"solver\": \"" << r.solver << "\", \"puzzles\": " << r.num_puzzles
+            << ", \"solved\": " << r.num_solved << ", \"puzzles_per_s\": " << r.puzzles_per_s
+            << ", \"p50_us\": " << r.p50_us << ", \"p99_us\": " << r.p99_us
+            << ", \"max_us\": " << r.max_us;
+        if (r.has_phases) {
+            out << ", \"build_us\": " << r.build_us << ", \"search_us\": " << r.search_us
+                << ", \"destroy_us\": " << r.destroy_us;
+        }
+        if (r.has_misses) {
+            out << ", \"l1d_misses\": " << r.l1d_misses
+                << ", \"llc_misses\": " << r.llc_misses;
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Result> results;
+    for (int kind = 0; kind < num_corpus_kinds; ++kind) {
+        const char* name = corpus_name(static_cast<CorpusKind>(kind));
+        if (!options.corpus.empty() && options.corpus != name)
+            continue;
+
+        std::size_t count = options.count;
+        if (kind == corpus_16x16)
+            count = std::max<std::size_t>(count / 4, 1);
+        else if (kind == corpus_25x25)
+            count = std::max<std::size_t>(count / 10, 1);
+
+        Clock::time_point start = Clock::now();
+        Corpus corpus = make_corpus(static_cast<CorpusKind>(kind), count, options.seed);
+        std::cerr << "corpus " << name << ": " << count << " puzzles generated in "
+                  << seconds_since(start) << " s" << std::endl;
+
+        for (std::size_t i = 0; i < sizeof(solver_names) / sizeof(solver_names[0]); ++i) {
+            if (options.solver.empty() || options.solver == solver_names[i])
+                results.push_back(run_solver(corpus, solver_names[i]));
+        }
+        if (options.solver.empty() || options.solver == "dlx-phases")
+            results.push_back(run_phases(corpus));
+    }
+
+    if (options.json)
+        write_json(std::cout, options, results);
+    else
+        write_csv(std::cout, results);
+    return 0;
+}
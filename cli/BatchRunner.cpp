@@ -0,0 +1,305 @@
+//! \file
+//! \brief BatchRunner implementation.
+//! \author Mathieu Turcotte
+
+#include <algorithm>  // std::max
+#include <string>
+#include <utility>
+#include <vector>
+#include <thread>
+#include <sstream>
+#include <stdexcept>
+
+#include "BatchRunner.hpp"
+#include "../src/Sudoku.hpp"
+#include "../src/BatchSolver.hpp"
+#include "../src/GridValidator.hpp"
+
+bool guess_region_size(std::size_t num_cells, unsigned short& region_num_row,
+        unsigned short& region_num_col) {
+    for (unsigned short rows = 5; rows > 0; --rows) {
+        for (unsigned short cols = rows; cols <= 5; ++cols) {
+            unsigned int size = rows * cols;
+            if (size * size == num_cells) {
+                region_num_row = rows;
+                region_num_col = cols;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+BatchRunner::BatchRunner(const Options& options, SolutionStore* store):
+    options(options), store(store), num_queued(0), num_chunks(0), input_done(false) {
+
+    if (this->options.num_threads == 0)
+        this->options.num_threads = 1;
+
+    // A few chunks per worker keep everybody busy while
+    // the writer waits for a slow chunk.
+    std::size_t max_chunks = 4 * this->options.num_threads + 2;
+    for (std::size_t i = 0; i < max_chunks; ++i) {
+        chunks.push_back(std::unique_ptr<Chunk>(new Chunk));
+        chunks.back()->lines.resize(chunk_size);
+        free_chunks.push_back(chunks.back().get());
+    }
+    for (unsigned int i = 0; i < this->options.num_threads; ++i)
+        queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue));
+}
+
+Summary BatchRunner::run(std::istream& in, std::ostream& out, std::ostream& err) {
+    summary = Summary();
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < options.num_threads; ++i)
+        workers.push_back(std::thread(&BatchRunner::work, this, i));
+    std::thread writer(&BatchRunner::write, this, std::ref(out), std::ref(err));
+
+    unsigned long line_number = 1;
+    for (;;) {
+        Chunk* chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (free_chunks.empty())
+                chunk_freed.wait(lock);
+            chunk = free_chunks.back();
+            free_chunks.pop_back();
+        }
+
+        chunk->num_lines = 0;
+        while (chunk->num_lines < chunk_size &&
+                std::getline(in, chunk->lines[chunk->num_lines])) {
+            std::string& line = chunk->lines[chunk->num_lines];
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            chunk->num_lines++;
+        }
+
+        if (chunk->num_lines == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            free_chunks.push_back(chunk);
+            break;
+        }
+
+        chunk->first_line = line_number;
+        line_number += chunk->num_lines;
+        chunk->sequence = num_chunks;
+
+        // Deal the chunks round robin, idle workers steal the rest. The
+        // chunk is counted before it is queued, so that a worker taking
+        // it right away can't bring the count below zero.
+        WorkerQueue& queue = *queues[num_chunks % queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            num_chunks++;
+            num_queued++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.chunks.push_back(chunk);
+        }
+        chunk_queued.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        input_done = true;
+    }
+    chunk_queued.notify_all();
+    chunk_solved.notify_all();
+
+    for (std::size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+    writer.join();
+
+    return summary;
+}
+
+void BatchRunner::work(unsigned int id) {
+    // Solvers keep per-solve state, each worker has its own. A solver
+    // searching a grid on several threads gets its share of the cores.
+    unsigned int num_cores = std::thread::hardware_concurrency();
+    unsigned int share = std::max(1u, num_cores / options.num_threads);
+    std::unique_ptr<SudokuSolver> solver(SudokuSolver::create(options.solver, share));
+    StoreSolver* stored = 0;
+    if (store) {
+        stored = new StoreSolver(*store, solver.release());
+        solver.reset(stored);
+    }
+
+    while (Chunk* chunk = take(id)) {
+        solve(*chunk, *solver);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            solved[chunk->sequence] = chunk;
+        }
+        chunk_solved.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stored) {
+        summary.num_found += stored->num_found();
+        summary.num_added += stored->num_added();
+        summary.num_skipped += stored->num_skipped();
+    }
+    // Each worker has its own cache.
+    SudokuSolver& inner = stored ? stored->inner() : *solver;
+    if (CachingSolver* cached = dynamic_cast<CachingSolver*>(&inner))
+        summary.cache_stats += cached->cache_stats();
+}
+
+BatchRunner::Chunk* BatchRunner::take(unsigned int id) {
+    for (;;) {
+        // First the worker own deque, then the others, oldest chunks first:
+        // the writer waits for them.
+        for (std::size_t k = 0; k < queues.size(); ++k) {
+            WorkerQueue& queue = *queues[(id + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.chunks.empty())
+                continue;
+
+            Chunk* chunk = queue.chunks.front();
+            queue.chunks.pop_front();
+            num_queued--;
+            return chunk;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (num_queued == 0 && !input_done)
+            chunk_queued.wait(lock);
+        if (num_queued == 0 && input_done)
+            return 0;
+    }
+}
+
+void BatchRunner::write(std::ostream& out, std::ostream& err) {
+    unsigned long next = 0;
+    for (;;) {
+        Chunk* chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::map<unsigned long, Chunk*>::iterator it;
+            while ((it = solved.find(next)) == solved.end()) {
+                if (input_done && next == num_chunks)
+                    return;
+                chunk_solved.wait(lock);
+            }
+            chunk = it->second;
+            solved.erase(it);
+        }
+
+        err << chunk->errors;
+        out.write(chunk->output.data(), chunk->output.size());
+        summary.num_puzzles += chunk->summary.num_puzzles;
+        summary.num_solved += chunk->summary.num_solved;
+        summary.num_invalid += chunk->summary.num_invalid;
+        summary.search_stats += chunk->summary.search_stats;
+        next++;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            free_chunks.push_back(chunk);
+        }
+        chunk_freed.notify_one();
+    }
+}
+
+void BatchRunner::solve(Chunk& chunk, SudokuSolver& solver) {
+    chunk.output.clear();
+    chunk.errors.clear();
+    chunk.summary.num_puzzles = chunk.num_lines;
+    chunk.summary.num_solved = 0;
+    chunk.summary.num_invalid = 0;
+    chunk.summary.search_stats.reset();
+
+    // Parse every line of the chunk first, so that the
+    // batch solver gets as many grids as possible. The grids
+    // of the chunk are reused while the geometry doesn't change.
+    std::vector<Sudoku>& grids = chunk.grids;
+    std::size_t grid_lines[chunk_size];
+    std::size_t num_grids = 0;
+    std::string conflict_message;
+
+    for (std::size_t i = 0; i < chunk.num_lines; ++i) {
+        const std::string& line = chunk.lines[i];
+        unsigned short rows = options.region_num_row;
+        unsigned short cols = options.region_num_col;
+        const char* error = "unsupported grid size";
+        if (rows != 0 || guess_region_size(line.size(), rows, cols)) {
+            if (num_grids == grids.size())
+                grids.push_back(Sudoku(rows, cols));
+            else if (grids[num_grids].region_size() != std::make_pair(rows, cols))
+                grids[num_grids] = Sudoku(rows, cols);
+
+            Sudoku::ParseStatus status = grids[num_grids].parse(line.data(), line.size());
+            GridConflict conflict;
+            if (status == Sudoku::parse_ok &&
+                    GridValidator::is_valid(grids[num_grids], &conflict)) {
+                grid_lines[num_grids++] = i;
+                continue;
+            }
+            // Grids with conflicting givens never reach the solver.
+            if (status == Sudoku::parse_ok) {
+                conflict_message = GridValidator::describe(grids[num_grids], conflict);
+                error = conflict_message.c_str();
+            } else {
+                error = Sudoku::describe(status);
+            }
+        }
+
+        std::ostringstream message;
+        message << "line " << chunk.first_line + i << ": " << error << "\n";
+        chunk.errors += message.str();
+        chunk.summary.num_invalid++;
+    }
+
+    // Behind a solution store, grids go one at a time so that each
+    // is looked up, and only those actually searched count.
+    bool solved[chunk_size];
+    BatchSolver* batch = dynamic_cast<BatchSolver*>(&solver);
+    if (batch != 0 && num_grids != 0) {
+        chunk.summary.num_solved += batch->solve_batch(&grids[0], num_grids, solved);
+    } else {
+        StoreSolver* stored = dynamic_cast<StoreSolver*>(&solver);
+        StatsDancingLinksSolver* instrumented = dynamic_cast<StatsDancingLinksSolver*>(
+                stored ? &stored->inner() : &solver);
+        for (std::size_t i = 0; i < num_grids; ++i) {
+            unsigned long long found = stored ? stored->num_found() : 0;
+            solved[i] = solver.solve(grids[i]);
+            chunk.summary.num_solved += solved[i];
+            if (instrumented && (!stored || stored->num_found() == found))
+                chunk.summary.search_stats += instrumented->search_stats();
+        }
+    }
+
+    // Write the whole chunk at once when every grid was solved,
+    // the output is the same size for grids of the same geometry.
+    bool all_solved = num_grids == chunk.num_lines;
+    for (std::size_t i = 0; all_solved && i < num_grids; ++i)
+        all_solved = solved[i] && grids[i].size() == grids[0].size();
+    if (all_solved && num_grids != 0) {
+        chunk.output.resize(num_grids * (grids[0].size() * grids[0].size() + 1));
+        Sudoku::write(&grids[0], num_grids, &chunk.output[0]);
+        return;
+    }
+
+    // Unsolved and invalid lines are echoed unchanged.
+    std::size_t next_grid = 0;
+    for (std::size_t i = 0; i < chunk.num_lines; ++i) {
+        if (next_grid < num_grids && grid_lines[next_grid] == i) {
+            if (solved[next_grid]) {
+                const Sudoku& grid = grids[next_grid];
+                std::size_t offset = chunk.output.size();
+                chunk.output.resize(offset + grid.size() * grid.size());
+                grid.write(&chunk.output[offset]);
+            } else {
+                chunk.output += chunk.lines[i];
+            }
+            next_grid++;
+        } else {
+            chunk.output += chunk.lines[i];
+        }
+        chunk.output += '\n';
+    }
+}
@@ -0,0 +1,154 @@
+//! \file
+//! \brief BatchRunner interface.
+//! \author Mathieu Turcotte
+
+#ifndef BATCH_RUNNER_H_
+#define BATCH_RUNNER_H_
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include "../src/SudokuSolver.hpp"
+#include "../src/CachingSolver.hpp"
+#include "../src/SolutionStore.hpp"
+#include "../src/Generator.hpp"
+
+//! \brief Batch counters.
+struct Summary {
+    unsigned long num_puzzles;      /**< Number of grids read. */
+    unsigned long num_solved;       /**< Number of grids solved. */
+    unsigned long num_invalid;      /**< Number of lines which couldn't be parsed. */
+    SearchStats search_stats;       /**< Search totals of the dlx-stats solver. */
+    CacheStats cache_stats;         /**< Cache totals of the dlx-cached solvers. */
+    unsigned long long num_found;   /**< Grids found in the solution store. */
+    unsigned long long num_added;   /**< Grids added to the solution store. */
+    unsigned long long num_skipped; /**< Grids of another geometry than the store. */
+
+    //! \brief Summary constructor (all counters 0).
+    Summary(): num_puzzles(0), num_solved(0), num_invalid(0),
+        num_found(0), num_added(0), num_skipped(0) {
+    }
+};
+
+//! \brief Batch options.
+struct Options {
+    std::string solver;             /**< Name of the solver. */
+    std::string input;              /**< Input file, standard input if empty. */
+    unsigned short region_num_row;  /**< Region vertical size, 0 to guess it. */
+    unsigned short region_num_col;  /**< Region horizontal size, 0 to guess it. */
+    unsigned int num_threads;       /**< Number of worker threads. */
+    bool enumerate;                 /**< Write every solution of each grid. */
+    bool parse_only;                /**< Only parse the grids, to time the parser. */
+    std::string binary_output;      /**< Binary grid file to write, empty to solve. */
+    bool store_solutions;           /**< Also store the solutions in binary_output. */
+    bool binary_input;              /**< The input is a binary grid file to write as text. */
+    unsigned long num_generated;    /**< Number of puzzles to generate, 0 to solve. */
+    unsigned int num_clues;         /**< Clue count of the generated puzzles, 0 for minimal. */
+    Symmetry symmetry;              /**< Symmetry of the generated puzzles. */
+    unsigned long seed;             /**< Seed of the generated puzzles. */
+    std::string database;           /**< Solution store, none if empty. */
+    std::size_t database_capacity;  /**< Records of the solution store if created. */
+};
+
+//! \brief Guess the region size of a grid from its number of cells.
+//! \param num_cells The number of cells of the grid.
+//! \param[out] region_num_row Region vertical size.
+//! \param[out] region_num_col Region horizontal size.
+//! \return False if no supported geometry has that many cells.
+bool guess_region_size(std::size_t num_cells, unsigned short& region_num_row,
+        unsigned short& region_num_col);
+
+//! \brief Solve a stream of grids, one per line, on several threads.
+//!
+//! The reader cuts the input into chunks of lines which are dealt to the
+//! workers deques. A worker takes chunks from the front of its own deque
+//! and, once it is empty, steals from the front of the others: solve times
+//! vary wildly, so a worker stuck on a hard grid doesn't hold back the
+//! chunks queued behind it. Solved chunks go through a reorder buffer and
+//! a writer thread outputs them in input order. The number of chunks in
+//! flight is bounded, which bounds the memory used.
+class BatchRunner {
+public:
+    //! \brief Number of lines per chunk.
+    static const std::size_t chunk_size = 64;
+
+    //! \brief BatchRunner constructor.
+    //! \param options The batch options.
+    //! \param store The solution store the workers look the grids up in
+    //!        before solving them (see StoreSolver), null for none.
+    //! \pre The solver name is valid (see SudokuSolver::create).
+    explicit BatchRunner(const Options& options, SolutionStore* store = 0);
+
+    //! \brief Solve every grid of a stream.
+    //! \param in The input stream.
+    //! \param out The output stream, receiving one line per input line.
+    //! \param err The stream receiving the parse errors.
+    //! \return The batch counters.
+    Summary run(std::istream& in, std::ostream& out, std::ostream& err);
+
+protected:
+    //! \brief A chunk of input lines and the corresponding output.
+    struct Chunk {
+        unsigned long sequence;         /**< Chunk position in the input. */
+        unsigned long first_line;       /**< Input line number of the first line. */
+        std::vector<std::string> lines; /**< Input lines. */
+        std::size_t num_lines;          /**< Number of lines used. */
+        std::vector<Sudoku> grids;      /**< Parsed grids, reused across chunks. */
+        std::string output;             /**< Solutions, one per line. */
+        std::string errors;             /**< Parse errors. */
+        Summary summary;                /**< Chunk counters. */
+    };
+
+    //! \brief Deque of chunks of a worker.
+    struct WorkerQueue {
+        std::mutex mutex;           /**< Protects the deque. */
+        std::deque<Chunk*> chunks;  /**< Chunks waiting to be solved. */
+    };
+
+    //! \brief Worker loop.
+    //! \param id The worker index.
+    void work(unsigned int id);
+
+    //! \brief Writer loop.
+    //! \param out The output stream.
+    //! \param err The stream receiving the parse errors.
+    void write(std::ostream& out, std::ostream& err);
+
+    //! \brief Take a chunk to solve, from the worker own deque or
+    //!        from the others.
+    //! \param id The worker index.
+    //! \return A chunk, or null once the input is exhausted.
+    Chunk* take(unsigned int id);
+
+    //! \brief Solve the lines of a chunk.
+    //! \param chunk The chunk.
+    //! \param solver The worker solver.
+    void solve(Chunk& chunk, SudokuSolver& solver);
+
+    Options options;                /**< Batch options. */
+    SolutionStore* store;           /**< Solution store, null for none. */
+
+    std::vector<std::unique_ptr<Chunk> > chunks;    /**< Every chunk, in flight or free. */
+    std::vector<Chunk*> free_chunks;                /**< Chunks ready to be filled. */
+    std::vector<std::unique_ptr<WorkerQueue> > queues;  /**< Deque of each worker. */
+    std::atomic<std::size_t> num_queued;            /**< Number of chunks in the deques. */
+    std::map<unsigned long, Chunk*> solved;         /**< Reorder buffer, by sequence. */
+    unsigned long num_chunks;       /**< Number of chunks read so far. */
+    bool input_done;                /**< True once the whole input is read. */
+    Summary summary;                /**< Batch counters. */
+
+    std::mutex mutex;                       /**< Protects the chunk lists and counters. */
+    std::condition_variable chunk_freed;    /**< Signaled when a chunk is free. */
+    std::condition_variable chunk_queued;   /**< Signaled when a chunk is queued. */
+    std::condition_variable chunk_solved;   /**< Signaled when a chunk is solved. */
+};
+
+#endif // BATCH_RUNNER_H_
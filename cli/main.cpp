@@ -0,0 +1,507 @@
+//! \file
+//! \brief Headless batch solver.
+//! \author Mathieu Turcotte
+//!
+//! Reads grids one per line, in the representation accepted by the Sudoku
+//! constructor, and writes the solutions one per line, in input order.
+//! Lines which can't be parsed or solved are echoed unchanged. A summary
+//! is printed on the standard error at the end.
+//!
+//! With -e, every solution of each grid is written instead, followed by
+//! an empty line. With -p, the grids are only parsed, to measure the
+//! parser throughput apart from the solvers.
+//!
+//! With -b or -B, the grids are written to a binary grid file instead (see
+//! GridFile.hpp), -B also storing their solutions. With -t, the input is a
+//! binary grid file, written as text: the solutions if it has some, the
+//! puzzles otherwise.
+//!
+//! With -G, no input is read: puzzles with a unique solution are generated
+//! instead (see PuzzleGenerator), one per line.
+//!
+//! With -d, the grids are looked up in a solution store before being
+//! solved, and those solved are added to it (see SolutionStore.hpp). The
+//! store is created if it doesn't exist, for the geometry given with -r
+//! and -c, which are then required, with room for -D records. Grids of
+//! another geometry than the store are only solved. Several processes
+//! can share the same store.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <algorithm>    // std::min
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "BatchRunner.hpp"
+#include "../src/SudokuSolver.hpp"
+#include "../src/GridFile.hpp"
+#include "../src/GridValidator.hpp"
+#include "../src/SolutionStore.hpp"
+
+namespace {
+
+void usage(const char* program) {
+    std::cerr << "Usage: " << program << " [-e | -p | -b output | -B output | -t] [-s solver] [-d database [-D records]] [-j threads] [-r rows -c columns] [file]\n"
+              << "       " << program << " -G count [-n clues] [-y none|rotational|mirror] [-g seed] [-j threads] [-r rows -c columns]\n"
+              << "  -e          write every solution of each grid (dancing links)\n"
+              << "  -p          only parse the grids and report the parser throughput\n"
+              << "  -b output   write the grids to a binary grid file\n"
+              << "  -B output   solve the grids, write them and their solutions to a binary grid file\n"
+              << "  -t          read a binary grid file and write it as text\n"
+              << "  -G count    generate puzzles with a unique solution (default: 9x9)\n"
+              << "  -n clues    clue count to stop at (default: 0, minimal puzzles)\n"
+              << "  -y symmetry symmetry of the clues (default: none)\n"
+              << "  -g seed     generator seed (default: 1)\n"
+              << "  -s solver   dlx (default), dlx-stats, dlx-parallel, dlx-cached, bitmask or batch\n"
+              << "  -d database look the grids up in a solution store and add those solved\n"
+              << "  -D records  capacity of the solution store if created (default: 262144,\n"
+              << "              about 32 MB for 9x9 grids)\n"
+              << "  -j threads  number of worker threads (default: one per core)\n"
+              << "  -r rows     number of rows in a region\n"
+              << "  -c columns  number of columns in a region\n"
+              << "The region size is guessed from the line length when not given.\n"
+              << "Grids are read from the standard input when no file is given.\n";
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    options.solver = "dlx";
+    options.region_num_row = 0;
+    options.region_num_col = 0;
+    options.num_threads = std::thread::hardware_concurrency();
+    options.enumerate = false;
+    options.parse_only = false;
+    options.store_solutions = false;
+    options.binary_input = false;
+    options.num_generated = 0;
+    options.num_clues = 0;
+    options.symmetry = symmetry_none;
+    options.seed = 1;
+    options.database_capacity = 1 << 18;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+            return false;
+        } else if (std::strcmp(arg, "-e") == 0) {
+            options.enumerate = true;
+        } else if (std::strcmp(arg, "-p") == 0) {
+            options.parse_only = true;
+        } else if (std::strcmp(arg, "-t") == 0) {
+            options.binary_input = true;
+        } else if (arg[0] == '-' && arg[1] != '\0' && i + 1 < argc) {
+            const char* value = argv[++i];
+            switch (arg[1]) {
+            case 's': options.solver = value; break;
+            case 'j': options.num_threads = std::atoi(value); break;
+            case 'r': options.region_num_row = std::atoi(value); break;
+            case 'c': options.region_num_col = std::atoi(value); break;
+            case 'b': options.binary_output = value; break;
+            case 'B': options.binary_output = value; options.store_solutions = true; break;
+            case 'G': options.num_generated = std::strtoul(value, 0, 10); break;
+            case 'n': options.num_clues = std::atoi(value); break;
+            case 'g': options.seed = std::strtoul(value, 0, 10); break;
+            case 'd': options.database = value; break;
+            case 'D': options.database_capacity = std::strtoul(value, 0, 10); break;
+            case 'y':
+                if (std::strcmp(value, "none") == 0)
+                    options.symmetry = symmetry_none;
+                else if (std::strcmp(value, "rotational") == 0)
+                    options.symmetry = symmetry_rotational;
+                else if (std::strcmp(value, "mirror") == 0)
+                    options.symmetry = symmetry_mirror;
+                else
+                    return false;
+                break;
+            default: return false;
+            }
+        } else if (options.input.empty() && arg[0] != '-') {
+            options.input = arg;
+        } else {
+            return false;
+        }
+    }
+    if (options.num_threads == 0)
+        options.num_threads = 1;
+    return (options.region_num_row == 0) == (options.region_num_col == 0) &&
+            options.region_num_row <= 5 && options.region_num_col <= 5 &&
+            options.enumerate + options.parse_only + options.binary_input +
+            !options.binary_output.empty() + (options.num_generated != 0) <= 1 &&
+            !(options.binary_input && options.input.empty()) &&
+            options.database_capacity != 0;
+}
+
+//! \brief Visitor writing each solution on its own line.
+class SolutionWriter: public SolutionVisitor {
+public:
+    explicit SolutionWriter(std::ostream& out): out(out) {
+    }
+
+    bool visit(const SolutionView& solution) {
+        line.resize(solution.size() + 1);
+        for (unsigned int i = 0; i < solution.size(); ++i) {
+            unsigned short value = solution.value(i);
+            line[solution.cell_index(i)] =
+                    static_cast<char>(value < 10 ? '0' + value : 'A' + value - 10);
+        }
+        line[solution.size()] = '\n';
+        out.write(line.data(), line.size());
+        return true;
+    }
+
+protected:
+    std::ostream& out;  /**< The output stream. */
+    std::string line;   /**< The line being written, reused. */
+};
+
+//! \brief Write every solution of each grid of a stream.
+Summary enumerate(std::istream& in, std::ostream& out, const Options& options) {
+    Summary summary;
+    DancingLinksSolver solver;
+    SolutionWriter writer(out);
+    Sudoku grid;
+    std::string line;
+    std::string conflict_message;
+
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        summary.num_puzzles++;
+
+        unsigned short rows = options.region_num_row;
+        unsigned short cols = options.region_num_col;
+        const char* error = "unsupported grid size";
+        if (rows != 0 || guess_region_size(line.size(), rows, cols)) {
+            if (grid.region_size() != std::make_pair(rows, cols))
+                grid = Sudoku(rows, cols);
+            Sudoku::ParseStatus status = grid.parse(line.data(), line.size());
+            GridConflict conflict;
+            error = Sudoku::describe(status);
+            if (status == Sudoku::parse_ok && !GridValidator::is_valid(grid, &conflict)) {
+                conflict_message = GridValidator::describe(grid, conflict);
+                error = conflict_message.c_str();
+            } else if (status == Sudoku::parse_ok) {
+                summary.num_solved += solver.enumerate_solutions(grid, writer) > 0;
+                error = 0;
+            }
+        }
+        if (error) {
+            std::cerr << "line " << summary.num_puzzles << ": " << error << "\n";
+            summary.num_invalid++;
+        }
+        out << '\n';
+    }
+    return summary;
+}
+
+//! \brief Parse every grid of a stream and report the parser throughput.
+//! \return The number of invalid grids.
+unsigned long benchmark_parse(std::istream& in, const Options& options) {
+    // Read the whole input first, only the parsing is timed.
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    const std::string input = buffer.str();
+
+    Sudoku grid;
+    unsigned long num_grids = 0;
+    unsigned long num_invalid = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (std::size_t begin = 0; begin < input.size(); ) {
+        std::size_t end = input.find('\n', begin);
+        if (end == std::string::npos)
+            end = input.size();
+        std::size_t length = end - begin;
+        if (length != 0 && input[end - 1] == '\r')
+            length--;
+        num_grids++;
+
+        unsigned short rows = options.region_num_row;
+        unsigned short cols = options.region_num_col;
+        if (rows != 0 || guess_region_size(length, rows, cols)) {
+            if (grid.region_size() != std::make_pair(rows, cols))
+                grid = Sudoku(rows, cols);
+            num_invalid += grid.parse(input.data() + begin, length) != Sudoku::parse_ok;
+        } else {
+            num_invalid++;
+        }
+        begin = end + 1;
+    }
+
+    double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    std::cerr << "parse: " << num_grids << " grids, " << num_invalid << " invalid, "
+              << input.size() << " bytes in " << seconds << " s ("
+              << (seconds > 0 ? num_grids / seconds : 0) << " grids/s, "
+              << (seconds > 0 ? input.size() / seconds / 1e6 : 0) << " MB/s)" << std::endl;
+    return num_invalid;
+}
+
+//! \brief Write the grids of a stream to a binary grid file.
+//! \return The batch counters, grids which can't be parsed are skipped.
+Summary write_binary(std::istream& in, const Options& options) throw(std::runtime_error) {
+    Summary summary;
+    std::unique_ptr<SudokuSolver> solver;
+    if (options.store_solutions)
+        solver.reset(SudokuSolver::create(options.solver));
+
+    std::unique_ptr<GridFileWriter> writer;
+    Sudoku grid;
+    std::string line;
+
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        summary.num_puzzles++;
+
+        // The geometry of the file is the one of its first grid.
+        unsigned short rows = options.region_num_row;
+        unsigned short cols = options.region_num_col;
+        if (writer) {
+            rows = grid.region_num_rows();
+            cols = grid.region_num_columns();
+        } else if (rows == 0 && !guess_region_size(line.size(), rows, cols)) {
+            std::cerr << "line " << summary.num_puzzles << ": unsupported grid size\n";
+            summary.num_invalid++;
+            continue;
+        }
+        if (!writer) {
+            grid = Sudoku(rows, cols);
+            writer.reset(new GridFileWriter(options.binary_output, rows, cols,
+                                            options.store_solutions));
+        }
+
+        Sudoku::ParseStatus status = grid.parse(line.data(), line.size());
+        if (status != Sudoku::parse_ok) {
+            std::cerr << "line " << summary.num_puzzles << ": "
+                      << Sudoku::describe(status) << "\n";
+            summary.num_invalid++;
+            continue;
+        }
+
+        if (solver) {
+            Sudoku solution(grid);
+            bool solved = solver->solve(solution);
+            summary.num_solved += solved;
+            writer->write(grid, solved ? &solution : 0);
+        } else {
+            writer->write(grid);
+        }
+    }
+
+    if (!writer)
+        writer.reset(new GridFileWriter(options.binary_output, 3, 3, options.store_solutions));
+    writer->close();
+    return summary;
+}
+
+//! \brief Write a binary grid file as text, one grid per line.
+void write_text(const GridFile& file, std::ostream& out) {
+    std::string line;
+    for (std::size_t i = 0; i < file.size(); ++i) {
+        line.clear();
+        if (file.has_solutions() && !file.solution(i).is_empty())
+            file.solution(i).append_to(line);
+        else
+            file.puzzle(i).append_to(line);
+        line += '\n';
+        out.write(line.data(), line.size());
+    }
+}
+
+//! \brief Generate puzzles and write them, one per line.
+//! \return The number of seconds taken.
+double generate(std::ostream& out, const Options& options) {
+    GeneratorOptions generator_options = {
+        options.region_num_row ? options.region_num_row : static_cast<unsigned short>(3),
+        options.region_num_col ? options.region_num_col : static_cast<unsigned short>(3),
+        options.seed, options.num_clues, options.symmetry, options.num_threads
+    };
+    PuzzleGenerator generator(generator_options);
+    Sudoku empty(generator_options.region_num_row, generator_options.region_num_col);
+
+    // Generate and write a block at a time, which bounds the memory used.
+    const std::size_t block_size = 4096;
+    std::vector<Sudoku> puzzles;
+    std::vector<char> buffer;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (unsigned long first = 0; first < options.num_generated; first += block_size) {
+        std::size_t n = std::min<unsigned long>(block_size, options.num_generated - first);
+        puzzles.assign(n, empty);
+        generator.generate(first, &puzzles[0], n);
+
+        buffer.resize(n * (empty.size() * empty.size() + 1));
+        out.write(&buffer[0], Sudoku::write(&puzzles[0], n, &buffer[0]));
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! \brief Open the solution store, creating it if it doesn't exist.
+//! \throw std::exception If the store can't be opened or created, or
+//!        doesn't hold grids of the geometry given with -r and -c.
+SolutionStore* open_store(const Options& options) throw(std::exception) {
+    std::unique_ptr<SolutionStore> store;
+    try {
+        store.reset(new SolutionStore(options.database));
+    } catch (const std::runtime_error&) {
+        // The geometry of the grids isn't known before they are read.
+        if (options.region_num_row == 0 && std::ifstream(options.database.c_str()).fail())
+            throw std::runtime_error("-r and -c are needed to create the solution store "
+                                     + options.database);
+
+        // An existing store which can't be opened fails again below,
+        // one just created by another process is used as is.
+        SolutionStore::create(options.database, options.region_num_row,
+                options.region_num_col, options.database_capacity);
+        store.reset(new SolutionStore(options.database));
+    }
+
+    if (options.region_num_row != 0 &&
+            (store->region_num_rows() != options.region_num_row ||
+             store->region_num_columns() != options.region_num_col)) {
+        std::ostringstream message;
+        message << "the solution store " << options.database << " holds grids of "
+                << store->region_num_rows() << "x" << store->region_num_columns()
+                << " regions";
+        throw std::runtime_error(message.str());
+    }
+    return store.release();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Check the solver name before starting the workers.
+    try {
+        std::unique_ptr<SudokuSolver> solver(SudokuSolver::create(options.solver));
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 2;
+    }
+
+    if (options.binary_input) {
+        try {
+            GridFile file(options.input);
+            write_text(file, std::cout);
+            std::cout.flush();
+            return 0;
+        } catch (const std::exception& err) {
+            std::cerr << err.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.num_generated != 0) {
+        std::ios::sync_with_stdio(false);
+        double seconds = generate(std::cout, options);
+        std::cout.flush();
+        std::cerr << options.num_generated << " puzzles generated in " << seconds
+                  << " s (" << (seconds > 0 ? options.num_generated / seconds : 0)
+                  << " puzzles/s)" << std::endl;
+        return 0;
+    }
+
+    std::ifstream file;
+    if (!options.input.empty()) {
+        file.open(options.input.c_str());
+        if (!file) {
+            std::cerr << "cannot open " << options.input << std::endl;
+            return 1;
+        }
+    }
+    std::istream& in = options.input.empty() ? std::cin : file;
+    std::ios::sync_with_stdio(false);
+
+    if (options.parse_only)
+        return benchmark_parse(in, options) ? 1 : 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    Summary summary;
+    if (options.enumerate) {
+        summary = enumerate(in, std::cout, options);
+    } else if (!options.binary_output.empty()) {
+        try {
+            summary = write_binary(in, options);
+        } catch (const std::exception& err) {
+            std::cerr << err.what() << std::endl;
+            return 1;
+        }
+    } else {
+        std::unique_ptr<SolutionStore> store;
+        if (!options.database.empty()) {
+            try {
+                store.reset(open_store(options));
+            } catch (const std::exception& err) {
+                std::cerr << err.what() << std::endl;
+                return 1;
+            }
+        }
+        BatchRunner runner(options, store.get());
+        summary = runner.run(in, std::cout, std::cerr);
+        if (store) {
+            std::cerr << "database: " << summary.num_found << " found, "
+                      << summary.num_added << " added, " << store->size() << " of "
+                      << store->capacity() << " records used" << std::endl;
+            if (summary.num_skipped != 0) {
+                std::cerr << "database: " << summary.num_skipped << " grids not looked up, "
+                          << "the store holds grids of " << store->region_num_rows() << "x"
+                          << store->region_num_columns() << " regions" << std::endl;
+            }
+        }
+    }
+    std::cout.flush();
+
+    double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    if (!options.binary_output.empty() && !options.store_solutions) {
+        std::cerr << summary.num_puzzles - summary.num_invalid << " puzzles written, "
+                  << summary.num_invalid << " invalid in " << seconds << " s" << std::endl;
+        return summary.num_invalid ? 1 : 0;
+    }
+
+    std::cerr << options.solver << ", " << options.num_threads << " threads: "
+              << summary.num_puzzles << " puzzles, "
+              << summary.num_solved << " solved, "
+              << summary.num_puzzles - summary.num_solved - summary.num_invalid
+              << " unsolvable, " << summary.num_invalid << " invalid in "
+              << seconds << " s (" << (seconds > 0 ? summary.num_puzzles / seconds : 0)
+              << " puzzles/s)" << std::endl;
+
+    if (options.solver == "dlx-stats") {
+        const SearchStats& stats = summary.search_stats;
+        std::cerr << "search: " << stats.nodes << " nodes, " << stats.backtracks
+                  << " backtracks, max depth " << stats.max_depth << ", "
+                  << stats.covers << " covers, " << stats.uncovers << " uncovers, "
+                  << stats.link_updates << " link updates, "
+                  << stats.choose_seconds << " s choosing columns, "
+                  << stats.build_seconds << " s building matrices" << std::endl;
+    }
+    if (options.solver == "dlx-cached") {
+        const CacheStats& stats = summary.cache_stats;
+        unsigned long long lookups = stats.hits + stats.misses + stats.skipped;
+        std::cerr << "cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+                  << stats.hit_rate() * 100 << "% hit rate), " << stats.skipped
+                  << " skipped, " << stats.evictions << " evictions, "
+                  << (lookups ? stats.lookup_seconds / lookups * 1e6 : 0)
+                  << " us per lookup, " << stats.entries << " entries in "
+                  << stats.memory_bytes << " bytes" << std::endl;
+    }
+
+    return summary.num_invalid ? 1 : 0;
+}
@@ -4,19 +4,38 @@
 #include <sstream>
 #include <fstream>
 #include "src/Sudoku.hpp"
-#include "src/Sudokusolver.hpp"
+#include "src/SudokuSolver.hpp"
+#include "solverthread.h"
 #include <QList>
 #include <QLabel>
 #include <QBoxLayout>
 #include <QMessageBox>
 #include <QMainWindow>//For Qt5
 #include <QPushButton>//For Qt5
+#include <QDir>
 
 using namespace std;
 
+namespace {
+
+// Blanks and characters out of the grid domain leave the cell empty,
+// the parser reports the latter when solving.
+unsigned char cellValue(const QString &text)
+{
+    ushort c = text.isEmpty() ? 0 : text[0].unicode();
+    if (text.size() == 1 && c >= '0' && c < '0' + 9)
+        return c - '0';
+    return Sudoku::empty;
+}
+
+}
+
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    solverThread(0),
+    validator(Sudoku(3, 3)),
+    engine(Sudoku(3, 3))
 {
     /*
      * ui ???
@@ -38,6 +57,8 @@ MainWindow::MainWindow(QWidget *parent) :
             lineEditList.append(lineEdit);
             lineEdit->setText(QString('0'));
             ui->gridLayoutSudoku->addWidget(lineEdit,j,i);
+            connect(lineEdit, SIGNAL(textChanged(QString)),
+                    this, SLOT(cellEdited(QString)));
         }
     }
     string grid = "4xxx3xxx2"
@@ -51,13 +72,49 @@ MainWindow::MainWindow(QWidget *parent) :
             "3xxx7xxx0"
 ;
     applyGrid(grid);
+
+    ui->pushButtonCancel->setEnabled(false);
+    openStore();
+}
+
+void MainWindow::openStore()
+{
+    // Solutions are kept across sessions in a store shared with the
+    // other instances. Without a usable store, grids are only solved.
+    string path = QDir(QDir::homePath()).filePath(".sudoku-solutions.db").toStdString();
+    try
+    {
+        store.reset(new SolutionStore(path));
+    }
+    catch (const std::exception&)
+    {
+        try
+        {
+            SolutionStore::create(path, 3, 3, 1 << 16);
+            store.reset(new SolutionStore(path));
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
 }
 void MainWindow::applyGrid(std::string grid)
 {
+    // Cells are set without going through cellEdited, the validator and
+    // the candidates are then rebuilt once for the whole grid.
+    Sudoku s(3, 3);
     for (int i = 0 ;i < 81 ;i++)
     {
+        lineEditList[i]->blockSignals(true);
         lineEditList[i]->setText( QString(grid[i]));
+        lineEditList[i]->blockSignals(false);
+        s.set_at(i, cellValue(lineEditList[i]->text()));
     }
+    validator.reset(s);
+    engine.reset(s);
+    for (int i = 0; i < 81; i++)
+        showCell(i);
+    showStatus();
 }
 
 std::string MainWindow::readGrid()
@@ -72,35 +129,195 @@ std::string MainWindow::readGrid()
 
 MainWindow::~MainWindow()
 {
+    // Don't leave the search running on a destroyed window.
+    if (solverThread)
+    {
+        solverThread->disconnect(this);
+        solverThread->cancel();
+        solverThread->wait();
+        delete solverThread;
+    }
     delete ui;
 }
 
 void MainWindow::on_pushButtonSolve_clicked()
 {
-    QMessageBox msgBox;
-    msgBox.setText("Qt Designer, c'est le bien !");
-    msgBox.exec();
-    //SUPER MEGA FUNCTION SOLVER
+    if (solverThread)
+        return;
+
     unsigned short num_rows = 3;
     unsigned short num_cols = 3;
-    try
+    string grid = readGrid();
+    Sudoku s(num_rows, num_cols);
+    Sudoku::ParseStatus status = s.parse(grid.data(), grid.size());
+    if (status != Sudoku::parse_ok)
+    {
+        ui->labelProgress->setText(QString::fromUtf8(Sudoku::describe(status)));
+        return;
+    }
+    GridConflict conflict;
+    if (!GridValidator::is_valid(s, &conflict))
     {
-        Sudoku s(readGrid(), num_rows, num_cols);
-        DancingLinksSolver dls;
-        dls.solve(s);
-        std::string solved = s.getString();
-        std::string solvedclear ="";
-        for (int i = 0; i < solved.length() ; i++)
+        ui->labelProgress->setText(QString::fromStdString(
+                GridValidator::describe(s, conflict)));
+        return;
+    }
+
+    // Grids solved before are answered from the store.
+    SolveInfo info;
+    Sudoku solution(s);
+    if (store && store->find(s, &solution, &info))
+    {
+        if (info.solved)
+        {
+            applyGrid(solution.getString());
+            ui->labelProgress->setText(tr("Solved from the database, %1 nodes explored once")
+                                       .arg(info.nodes));
+        }
+        else
         {
-            if(solved[i] != ' ')
-            {
-                solvedclear += solved[i];
-            }
+            ui->labelProgress->setText(tr("No solution (from the database)"));
         }
-        applyGrid(solvedclear);
+        return;
     }
-    catch(const std::exception& err)
+
+    // The search runs on its own thread so that the window stays
+    // responsive and the search can be cancelled.
+    pendingPuzzle = s;
+    solveTimer.start();
+    solverThread = new SolverThread(s);
+    connect(solverThread, SIGNAL(nodesVisited(qulonglong)),
+            this, SLOT(showProgress(qulonglong)));
+    connect(solverThread, SIGNAL(searchDone(int,QString,qulonglong)),
+            this, SLOT(searchDone(int,QString,qulonglong)));
+    ui->pushButtonSolve->setEnabled(false);
+    ui->pushButtonCancel->setEnabled(true);
+    ui->labelProgress->setText(tr("Searching..."));
+    solverThread->start();
+}
+
+void MainWindow::on_pushButtonCancel_clicked()
+{
+    if (solverThread)
+        solverThread->cancel();
+}
+
+void MainWindow::showProgress(qulonglong nodes)
+{
+    ui->labelProgress->setText(tr("Searching: %1 nodes explored").arg(nodes));
+}
+
+void MainWindow::searchDone(int status, QString grid, qulonglong nodes)
+{
+    solverThread->wait();
+    solverThread->deleteLater();
+    solverThread = 0;
+    ui->pushButtonSolve->setEnabled(true);
+    ui->pushButtonCancel->setEnabled(false);
+
+    if (store && status != DancingLinksSolver::search_cancelled)
+    {
+        SolveInfo info;
+        info.solved = status == DancingLinksSolver::search_solved;
+        info.nanoseconds = solveTimer.nsecsElapsed();
+        info.nodes = nodes;
+        Sudoku solution(pendingPuzzle);
+        if (info.solved)
+            solution.parse(grid.toStdString().data(), grid.size());
+        store->insert(pendingPuzzle, info.solved ? &solution : 0, info);
+    }
+
+    switch (status)
+    {
+    case DancingLinksSolver::search_solved:
+        applyGrid(grid.toStdString());
+        ui->labelProgress->setText(tr("Solved, %1 nodes explored").arg(nodes));
+        break;
+    case DancingLinksSolver::search_cancelled:
+        ui->labelProgress->setText(tr("Cancelled after %1 nodes").arg(nodes));
+        break;
+    default:
+        ui->labelProgress->setText(tr("No solution, %1 nodes explored").arg(nodes));
+        break;
+    }
+}
+
+void MainWindow::cellEdited(const QString &text)
+{
+    int index = lineEditList.indexOf(qobject_cast<QLineEdit *>(sender()));
+    if (index < 0)
+        return;
+
+    unsigned char value = cellValue(text);
+    validator.set(index / 9, index % 9, value);
+    engine.set(index / 9, index % 9, value);
+
+    // Only the cell and its row, column and region peers can change.
+    int row = index / 9;
+    int col = index % 9;
+    int top = row / 3 * 3;
+    int left = col / 3 * 3;
+    for (int i = 0; i < 9; i++)
+    {
+        showCell(row * 9 + i);
+        if (i != row)
+            showCell(i * 9 + col);
+        int r = top + i / 3;
+        int c = left + i % 3;
+        if (r != row && c != col)
+            showCell(r * 9 + c);
+    }
+    showStatus();
+}
+
+void MainWindow::showCell(int index)
+{
+    // Restyling a cell is costly, only do it when its conflict changes.
+    QLineEdit *lineEdit = lineEditList[index];
+    QString style = validator.conflicting(index / 9, index % 9) ?
+            QString("background-color: #f4a0a0") : QString();
+    if (lineEdit->styleSheet() != style)
+        lineEdit->setStyleSheet(style);
+
+    QString tip;
+    uint32_t values = engine.candidates(index / 9, index % 9);
+    if (values != 0)
     {
-        cout << err.what() << endl;
+        tip = tr("%n candidate(s):", 0, engine.num_candidates(index / 9, index % 9));
+        for (int v = 0; v < 9; v++)
+            if (values & (1u << v))
+                tip += ' ' + QString::number(v);
+    }
+    lineEdit->setToolTip(tip);
+}
+
+void MainWindow::showStatus()
+{
+    // Leave the label to the search while it runs.
+    if (solverThread)
+        return;
+
+    DeadEnd deadEnd;
+    Hint hint;
+    if (!GridValidator::is_valid(validator.grid()))
+        ui->labelProgress->clear();
+    else if (engine.find_dead_end(deadEnd))
+    {
+        if (deadEnd.kind == DeadEnd::no_candidate)
+            ui->labelProgress->setText(tr("Unsolvable: r%1c%2 has no candidate left")
+                    .arg(deadEnd.cell / 9 + 1).arg(deadEnd.cell % 9 + 1));
+        else
+        {
+            static const char *units[] = {
+                QT_TR_NOOP("row"), QT_TR_NOOP("column"), QT_TR_NOOP("region") };
+            ui->labelProgress->setText(tr("Unsolvable: %1 %2 has no place left for %3")
+                    .arg(tr(units[deadEnd.unit / 9])).arg(deadEnd.unit % 9 + 1)
+                    .arg(deadEnd.value));
+        }
     }
+    else if (engine.find_hint(hint))
+        ui->labelProgress->setText(tr("Hint: r%1c%2 must hold %3")
+                .arg(hint.cell / 9 + 1).arg(hint.cell % 9 + 1).arg(hint.value));
+    else
+        ui->labelProgress->clear();
 }
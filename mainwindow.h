@@ -1,8 +1,14 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <memory>
 #include <QMainWindow>
 #include <QLineEdit>
+#include <QElapsedTimer>
+#include "src/GridValidator.hpp"
+#include "src/CandidateEngine.hpp"
+#include "src/SolutionStore.hpp"
+class SolverThread;
 namespace Ui {
 class MainWindow;
 }
@@ -19,9 +25,23 @@ public:
         void oldSolve();*/
 private slots:
         void on_pushButtonSolve_clicked();
+        void on_pushButtonCancel_clicked();
+        void showProgress(qulonglong nodes);
+        void searchDone(int status, QString grid, qulonglong nodes);
+        void cellEdited(const QString &text);
 private:
+    void showCell(int index);
+    void showStatus();
+    void openStore();
+
     Ui::MainWindow *ui;
     QList<QLineEdit *> lineEditList;
+    SolverThread *solverThread;
+    GridValidator validator;
+    CandidateEngine engine;
+    std::unique_ptr<SolutionStore> store;
+    Sudoku pendingPuzzle;
+    QElapsedTimer solveTimer;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,34 @@
+#include "solverthread.h"
+
+// Milliseconds between two progress reports.
+static const qint64 reportInterval = 100;
+
+SolverThread::SolverThread(const Sudoku& grid, QObject *parent) :
+    QThread(parent),
+    grid(grid)
+{
+}
+
+void SolverThread::cancel()
+{
+    // Thread safe: the token only raises an atomic flag.
+    token.cancel();
+}
+
+void SolverThread::progress(unsigned long long nodes)
+{
+    // Called on the solver thread after each slice of the search.
+    if (lastReport.elapsed() >= reportInterval)
+    {
+        lastReport.restart();
+        emit nodesVisited(nodes);
+    }
+}
+
+void SolverThread::run()
+{
+    lastReport.start();
+    int status = solver.solve_within(grid, token, this);
+    emit searchDone(status, QString::fromStdString(grid.getString()),
+                    solver.search_nodes());
+}
@@ -0,0 +1,34 @@
+#ifndef SOLVERTHREAD_H
+#define SOLVERTHREAD_H
+
+#include <QThread>
+#include <QString>
+#include <QElapsedTimer>
+#include "src/Sudoku.hpp"
+#include "src/SudokuSolver.hpp"
+#include "src/CancelToken.hpp"
+
+/*
+ * Solves one grid off the GUI thread. The search can be cancelled at any
+ * time and reports the number of nodes visited a few times a second.
+ */
+class SolverThread : public QThread, public SearchProgress
+{
+    Q_OBJECT
+public:
+    explicit SolverThread(const Sudoku& grid, QObject *parent = 0);
+    void cancel();
+    void progress(unsigned long long nodes);
+signals:
+    void nodesVisited(qulonglong nodes);
+    void searchDone(int status, QString grid, qulonglong nodes);
+protected:
+    void run();
+private:
+    Sudoku grid;
+    DancingLinksSolver solver;
+    CancelToken token;
+    QElapsedTimer lastReport;
+};
+
+#endif // SOLVERTHREAD_H
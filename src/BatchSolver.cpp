@@ -0,0 +1,275 @@
+//! \file
+//! \brief BatchSolver implementation.
+//! \author Mathieu Turcotte
+
+#include <cstring>  // std::memcpy
+#include <stdint.h>
+
+#include "BatchSolver.hpp"
+
+namespace {
+
+const unsigned int size = 9;
+const unsigned int num_cells = 81;
+const unsigned int num_peers = 20;
+const uint16_t full = 0x1FF;
+
+#if defined(__GNUC__)
+//! \brief The candidates of one cell for each grid of a group.
+typedef uint16_t lanes_t __attribute__((vector_size(32)));
+
+// Helpers take and give vectors by reference: GCC warns that passing
+// or returning them by value depends on AVX being enabled.
+
+//! \brief Keep the lanes which have at most one candidate.
+inline void singles(const lanes_t& c, lanes_t& out) {
+    out = c & reinterpret_cast<lanes_t>((c & (c - 1)) == 0);
+}
+
+//! \brief Set every bit of the lanes which are not 0.
+inline void nonzero(const lanes_t& c, lanes_t& out) {
+    out = reinterpret_cast<lanes_t>(c != 0);
+}
+
+inline bool any(const lanes_t& c) {
+    uint64_t words[4];
+    std::memcpy(words, &c, sizeof(words));
+    return (words[0] | words[1] | words[2] | words[3]) != 0;
+}
+#else
+struct lanes_t {
+    uint16_t lane[16];
+    uint16_t& operator[](unsigned int i) { return lane[i]; }
+    uint16_t operator[](unsigned int i) const { return lane[i]; }
+};
+
+inline lanes_t operator&(lanes_t a, lanes_t b) {
+    for (unsigned int i = 0; i < 16; ++i)
+        a[i] &= b[i];
+    return a;
+}
+
+inline lanes_t operator|(lanes_t a, lanes_t b) {
+    for (unsigned int i = 0; i < 16; ++i)
+        a[i] |= b[i];
+    return a;
+}
+
+inline lanes_t operator^(lanes_t a, lanes_t b) {
+    for (unsigned int i = 0; i < 16; ++i)
+        a[i] ^= b[i];
+    return a;
+}
+
+inline lanes_t operator~(lanes_t a) {
+    for (unsigned int i = 0; i < 16; ++i)
+        a[i] = ~a[i];
+    return a;
+}
+
+inline lanes_t& operator&=(lanes_t& a, lanes_t b) { return a = a & b; }
+inline lanes_t& operator|=(lanes_t& a, lanes_t b) { return a = a | b; }
+
+inline void singles(const lanes_t& c, lanes_t& out) {
+    for (unsigned int i = 0; i < 16; ++i)
+        out[i] = (c[i] & (c[i] - 1)) ? 0 : c[i];
+}
+
+inline void nonzero(const lanes_t& c, lanes_t& out) {
+    for (unsigned int i = 0; i < 16; ++i)
+        out[i] = c[i] ? 0xFFFF : 0;
+}
+
+inline bool any(lanes_t c) {
+    uint16_t bits = 0;
+    for (unsigned int i = 0; i < 16; ++i)
+        bits |= c[i];
+    return bits != 0;
+}
+#endif
+
+//! \brief Unit and peer tables of the 9x9 geometry.
+struct Tables {
+    unsigned char units[27][size];              /**< Cells of each row, column and region. */
+    unsigned char peers[num_cells][num_peers];  /**< Cells sharing a unit with each cell. */
+
+    Tables() {
+        for (unsigned int row = 0; row < size; ++row) {
+            for (unsigned int col = 0; col < size; ++col) {
+                unsigned int cell = row * size + col;
+                units[row][col] = cell;
+                units[size + col][row] = cell;
+                units[2 * size + (row / 3) * 3 + col / 3][(row % 3) * 3 + col % 3] = cell;
+            }
+        }
+        for (unsigned int cell = 0; cell < num_cells; ++cell) {
+            unsigned int row = cell / size;
+            unsigned int col = cell % size;
+            unsigned int count = 0;
+            for (unsigned int other = 0; other < num_cells; ++other) {
+                unsigned int other_row = other / size;
+                unsigned int other_col = other % size;
+                if (other != cell && (other_row == row || other_col == col ||
+                        (other_row / 3 == row / 3 && other_col / 3 == col / 3)))
+                    peers[cell][count++] = other;
+            }
+        }
+    }
+};
+
+const Tables tables;
+
+//! \brief Propagate singles on every lane until nothing changes.
+//! \param[in,out] cells The candidates of each cell.
+//!
+//! A lane without solution ends up with a cell without candidate.
+#if defined(__GNUC__) && defined(__x86_64__)
+__attribute__((target_clones("avx2", "default")))
+#endif
+void propagate(lanes_t* cells) {
+    bool progress = true;
+
+    while (progress) {
+        lanes_t changes = lanes_t();
+
+        // Naked singles: remove the value of every solved
+        // cell from its peers.
+        lanes_t solved[num_cells];
+        for (unsigned int cell = 0; cell < num_cells; ++cell)
+            singles(cells[cell], solved[cell]);
+
+        for (unsigned int cell = 0; cell < num_cells; ++cell) {
+            lanes_t taken = lanes_t();
+            for (unsigned int i = 0; i < num_peers; ++i)
+                taken |= solved[tables.peers[cell][i]];
+
+            lanes_t candidates = cells[cell] & ~taken;
+            changes |= candidates ^ cells[cell];
+            cells[cell] = candidates;
+        }
+
+        // Hidden singles: a value possible in a single cell of a unit
+        // has to go there.
+        for (unsigned int unit = 0; unit < 27; ++unit) {
+            const unsigned char* members = tables.units[unit];
+            lanes_t once = lanes_t();
+            lanes_t twice = lanes_t();
+            for (unsigned int i = 0; i < size; ++i) {
+                twice |= once & cells[members[i]];
+                once |= cells[members[i]];
+            }
+
+            lanes_t hidden = once & ~twice;
+            for (unsigned int i = 0; i < size; ++i) {
+                lanes_t candidates = cells[members[i]];
+                lanes_t only_here = candidates & hidden;
+                lanes_t placed;
+                nonzero(only_here, placed);
+                candidates = only_here | (candidates & ~placed);
+                changes |= candidates ^ cells[members[i]];
+                cells[members[i]] = candidates;
+            }
+        }
+
+        progress = any(changes);
+    }
+}
+
+} // namespace
+
+bool BatchSolver::solve(Sudoku& s) {
+    return solve_batch(&s, 1) == 1;
+}
+
+std::size_t BatchSolver::solve_batch(Sudoku* first, std::size_t n, bool* solved) {
+    std::size_t num_solved = 0;
+    Sudoku* group[lanes];
+    bool group_solved[lanes];
+    std::size_t group_index[lanes];
+    std::size_t group_size = 0;
+
+    for (std::size_t i = 0; i <= n; ++i) {
+        // Solve the group once full, and after the last grid.
+        if (group_size == lanes || (i == n && group_size)) {
+            num_solved += solve_lanes(group, group_size, group_solved);
+            if (solved) {
+                for (std::size_t lane = 0; lane < group_size; ++lane)
+                    solved[group_index[lane]] = group_solved[lane];
+            }
+            group_size = 0;
+        }
+        if (i == n)
+            break;
+
+        Sudoku& s = first[i];
+        if (s.region_num_rows() != 3 || s.region_num_columns() != 3) {
+            bool grid_solved = fallback.solve(s);
+            num_solved += grid_solved;
+            if (solved)
+                solved[i] = grid_solved;
+            continue;
+        }
+
+        group_index[group_size] = i;
+        group[group_size++] = &s;
+    }
+
+    return num_solved;
+}
+
+const char* BatchSolver::kernel() {
+#if defined(__GNUC__) && defined(__x86_64__)
+    return __builtin_cpu_supports("avx2") ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+std::size_t BatchSolver::solve_lanes(Sudoku** grids, std::size_t n,
+        bool* solved) {
+    lanes_t cells[num_cells];
+
+    // Interleave the grids, unused lanes are left without candidate.
+    for (unsigned int cell = 0; cell < num_cells; ++cell) {
+        cells[cell] = lanes_t();
+        for (std::size_t lane = 0; lane < n; ++lane) {
+            unsigned char value = grids[lane]->at(cell);
+            cells[cell][lane] = value == Sudoku::empty ? full : 1u << value;
+        }
+    }
+
+    propagate(cells);
+
+    std::size_t num_solved = 0;
+    for (std::size_t lane = 0; lane < n; ++lane) {
+        solved[lane] = false;
+        bool dead_end = false;
+        bool complete = true;
+        for (unsigned int cell = 0; cell < num_cells; ++cell) {
+            uint16_t candidates = cells[cell][lane];
+            dead_end |= candidates == 0;
+            complete &= (candidates & (candidates - 1)) == 0;
+        }
+        if (dead_end)
+            continue;
+
+        // Start the search from the propagated grid, and only
+        // keep it if the search succeeds.
+        Sudoku s(*grids[lane]);
+        for (unsigned int cell = 0; cell < num_cells; ++cell) {
+            uint16_t candidates = cells[cell][lane];
+            if ((candidates & (candidates - 1)) == 0) {
+                unsigned int value = 0;
+                while (!(candidates & (1u << value)))
+                    ++value;
+                s.set_at(cell, value);
+            }
+        }
+        if (complete || fallback.solve(s)) {
+            *grids[lane] = s;
+            solved[lane] = true;
+            num_solved++;
+        }
+    }
+    return num_solved;
+}
@@ -0,0 +1,56 @@
+//! \file
+//! \brief BatchSolver interface.
+//! \author Mathieu Turcotte
+
+#ifndef BATCH_SOLVER_H_
+#define BATCH_SOLVER_H_
+
+#include <cstddef>
+
+#include "SudokuSolver.hpp"
+#include "BitmaskSolver.hpp"
+
+//! \brief Solver for batches of independent 9x9 grids.
+//!
+//! The candidates of up to 16 grids are interleaved, one grid per SIMD
+//! lane, and singles are propagated on every lane at once. The kernel is
+//! compiled for AVX2 and for the x86-64 baseline (SSE2), the CPU picks
+//! one at load time; other targets get plain loops. Grids which still
+//! need branching once nothing is left to propagate are finished one by
+//! one by a BitmaskSolver, as are grids of any other size.
+class BatchSolver: public SudokuSolver {
+public:
+    //! \brief Number of grids propagated together.
+    static const std::size_t lanes = 16;
+
+    //! \brief Solve a sudoku grid.
+    //! \param[out] s The sudoku grid to solve.
+    //! \return True if the grid was solved, false otherwise.
+    bool solve(Sudoku& s);
+
+    //! \brief Solve a range of sudoku grids.
+    //! \param[out] first A pointer to the first grid of the range.
+    //! \param n The number of grids in the range.
+    //! \param[out] solved If not null, receives for each grid whether it
+    //!                    was solved.
+    //! \return The number of grids solved.
+    //!
+    //! Grids without solution are left untouched.
+    std::size_t solve_batch(Sudoku* first, std::size_t n, bool* solved = 0);
+
+    //! \brief Get the name of the kernel used on this CPU.
+    //! \return "avx2", "sse2" or "scalar".
+    static const char* kernel();
+
+protected:
+    //! \brief Solve up to lanes 9x9 grids together.
+    //! \param[out] grids Pointers to the grids.
+    //! \param n The number of grids.
+    //! \param[out] solved Receives for each grid whether it was solved.
+    //! \return The number of grids solved.
+    std::size_t solve_lanes(Sudoku** grids, std::size_t n, bool* solved);
+
+    BitmaskSolver fallback;     /**< Solver for the grids needing a search. */
+};
+
+#endif // BATCH_SOLVER_H_
@@ -0,0 +1,313 @@
+//! \file
+//! \brief BitmaskSolver implementation.
+//! \author Mathieu Turcotte
+
+#include <vector>
+#include <cstring>  // std::memcpy
+
+#include "BitmaskSolver.hpp"
+
+namespace {
+
+//! \brief Count the bits set in a mask.
+inline unsigned int popcount(uint32_t mask) {
+#if defined(__GNUC__)
+    return __builtin_popcount(mask);
+#else
+    unsigned int count = 0;
+    for (; mask; mask &= mask - 1)
+        count++;
+    return count;
+#endif
+}
+
+//! \brief Get the index of the lowest bit set in a mask.
+//! \pre The mask is not 0.
+inline unsigned int ctz(uint32_t mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    unsigned int index = 0;
+    for (; !(mask & 1); mask >>= 1)
+        index++;
+    return index;
+#endif
+}
+
+} // namespace
+
+BitmaskSolver::BitmaskSolver(bool specialized): specialized(specialized),
+    grid_size(0), region_num_row(0), region_num_col(0), num_cells(0), num_peers(0) {
+}
+
+bool BitmaskSolver::solve(Sudoku& s) {
+    if (s.size() != grid_size || s.region_num_rows() != region_num_row)
+        set_geometry(s);
+
+    if (specialized) {
+        switch (region_num_row * 8 + region_num_col) {
+        case 2 * 8 + 2: return solve<FixedGeometry<2, 2> >(s, masks16);
+        case 2 * 8 + 3: return solve<FixedGeometry<2, 3> >(s, masks16);
+        case 3 * 8 + 2: return solve<FixedGeometry<3, 2> >(s, masks16);
+        case 3 * 8 + 3: return solve<FixedGeometry<3, 3> >(s, masks16);
+        case 4 * 8 + 4: return solve<FixedGeometry<4, 4> >(s, masks16);
+        case 5 * 8 + 5: return solve<FixedGeometry<5, 5> >(s, masks32);
+        default: break;
+        }
+    }
+
+    if (grid_size <= 16)
+        return solve<DynamicGeometry<uint16_t> >(s, masks16);
+    return solve<DynamicGeometry<uint32_t> >(s, masks32);
+}
+
+void BitmaskSolver::set_geometry(const Sudoku& s) {
+    grid_size = s.size();
+    region_num_row = s.region_num_rows();
+    region_num_col = s.region_num_columns();
+    num_cells = grid_size * grid_size;
+    num_peers = 2 * (grid_size - 1) + (region_num_row - 1) * (region_num_col - 1);
+
+    // Units 0 to size-1 are the rows, then come the
+    // columns and the regions.
+    cell_units.resize(num_cells * 3);
+    unit_cells.resize(num_cells * 3);
+    std::vector<unsigned short> unit_fill(grid_size * 3, 0);
+
+    for (unsigned int row = 0; row < grid_size; ++row) {
+        for (unsigned int col = 0; col < grid_size; ++col) {
+            unsigned int cell = row * grid_size + col;
+            unsigned int region = (row / region_num_row) * region_num_row
+                    + col / region_num_col;
+            unsigned int units[3] = { row, grid_size + col,
+                                      2 * grid_size + region };
+            for (unsigned int k = 0; k < 3; ++k) {
+                cell_units[cell * 3 + k] = units[k];
+                unit_cells[units[k] * grid_size + unit_fill[units[k]]++] = cell;
+            }
+        }
+    }
+
+    // The peers of a cell are the other cells of its row and column,
+    // plus the cells of its region which are in neither of them.
+    cell_peers.resize(num_cells * num_peers);
+    for (unsigned int cell = 0; cell < num_cells; ++cell) {
+        unsigned short* peers = &cell_peers[cell * num_peers];
+        unsigned int count = 0;
+        const unsigned short* units = &cell_units[cell * 3];
+        for (unsigned int k = 0; k < 3; ++k) {
+            for (unsigned int i = 0; i < grid_size; ++i) {
+                unsigned int peer = unit_cells[units[k] * grid_size + i];
+                if (peer == cell)
+                    continue;
+                if (k == 2 && (cell_units[peer * 3] == units[0] ||
+                               cell_units[peer * 3 + 1] == units[1]))
+                    continue;
+                peers[count++] = peer;
+            }
+        }
+    }
+
+    // Every level of the search places at least one value.
+    singles.resize(num_cells * (num_peers + 1));
+    grids.resize((num_cells + 1) * num_cells);
+    if (grid_size <= 16)
+        masks16.resize((num_cells + 1) * (num_cells + grid_size * 3));
+    else
+        masks32.resize((num_cells + 1) * (num_cells + grid_size * 3));
+}
+
+template <class Geometry>
+BitmaskSolver::Level<typename Geometry::Mask> BitmaskSolver::level(
+        const Geometry& g, unsigned int depth,
+        std::vector<typename Geometry::Mask>& masks) {
+    Level<typename Geometry::Mask> l;
+    l.cells = &grids[depth * g.num_cells()];
+    l.candidates = &masks[depth * g.num_masks()];
+    l.used = l.candidates + g.num_cells();
+    return l;
+}
+
+template <class Geometry>
+bool BitmaskSolver::solve(Sudoku& s, std::vector<typename Geometry::Mask>& masks) {
+    typedef typename Geometry::Mask Mask;
+    const Geometry g(*this);
+    Level<Mask> l = level(g, 0, masks);
+    Mask full = static_cast<Mask>((1u << g.size()) - 1);
+
+    std::memset(l.cells, empty, g.num_cells());
+    std::memset(l.used, 0, g.size() * 3 * sizeof(Mask));
+    for (unsigned int cell = 0; cell < g.num_cells(); ++cell)
+        l.candidates[cell] = full;
+
+    // Place the predefined values. Cells left with a single candidate
+    // are handled by the propagation, which checks every cell anyway.
+    unsigned int num_singles = 0;
+    for (unsigned int cell = 0; cell < g.num_cells(); ++cell) {
+        unsigned int value = s.at(cell);
+        if (value == Sudoku::empty)
+            continue;
+
+        if (!(l.candidates[cell] & (1u << value)) ||
+                !place(g, l, cell, value, &singles[0], num_singles))
+            return false;
+        num_singles = 0;
+    }
+
+    if (!search(g, 0, masks))
+        return false;
+
+    for (unsigned int cell = 0; cell < g.num_cells(); ++cell)
+        s.set_at(cell, l.cells[cell]);
+    return true;
+}
+
+template <class Geometry>
+bool BitmaskSolver::search(const Geometry& g, unsigned int depth,
+        std::vector<typename Geometry::Mask>& masks) {
+    typedef typename Geometry::Mask Mask;
+    Level<Mask> l = level(g, depth, masks);
+
+    unsigned int branch_cell;
+    if (!propagate(g, l, branch_cell))
+        return false;
+    if (branch_cell == g.num_cells())
+        return true;
+
+    Level<Mask> next = level(g, depth + 1, masks);
+    Mask candidates = l.candidates[branch_cell];
+
+    // Try each candidate on a copy of the current level.
+    while (candidates) {
+        unsigned int value = ctz(candidates);
+        candidates &= candidates - 1;
+
+        std::memcpy(next.cells, l.cells, g.num_cells());
+        std::memcpy(next.candidates, l.candidates, g.num_masks() * sizeof(Mask));
+
+        unsigned int num_singles = 0;
+        if (place(g, next, branch_cell, value, &singles[0], num_singles) &&
+                search(g, depth + 1, masks)) {
+            std::memcpy(l.cells, next.cells, g.num_cells());
+            return true;
+        }
+    }
+    return false;
+}
+
+template <class Geometry>
+bool BitmaskSolver::propagate(const Geometry& g,
+        const Level<typename Geometry::Mask>& l, unsigned int& branch_cell) {
+
+    typedef typename Geometry::Mask Mask;
+    const unsigned int size = g.size();
+    const unsigned int num_cells = g.num_cells();
+    const Mask full = static_cast<Mask>((1u << size) - 1);
+    unsigned short* stack = &singles[0];
+    unsigned int num_singles = 0;
+
+    // Start from every cell left with a single candidate.
+    for (unsigned int cell = 0; cell < num_cells; ++cell) {
+        Mask candidates = l.candidates[cell];
+        if (candidates && !(candidates & (candidates - 1)))
+            stack[num_singles++] = cell;
+    }
+
+    for (;;) {
+        // Naked singles: cells left with a single candidate.
+        while (num_singles) {
+            unsigned int cell = stack[--num_singles];
+            Mask candidates = l.candidates[cell];
+            // Placed already, through another unit.
+            if (l.cells[cell] != empty)
+                continue;
+            if (!place(g, l, cell, ctz(candidates), stack, num_singles))
+                return false;
+        }
+
+        // Hidden singles: values with a single possible cell in a unit.
+        for (unsigned int unit = 0; unit < size * 3; ++unit) {
+            const unsigned short* members = &unit_cells[unit * size];
+            Mask once = 0;
+            Mask twice = 0;
+
+            for (unsigned int i = 0; i < size; ++i) {
+                Mask candidates = l.candidates[members[i]];
+                twice |= once & candidates;
+                once |= candidates;
+            }
+
+            // A value missing from the unit can't be placed anywhere.
+            if ((once | l.used[unit]) != full)
+                return false;
+
+            Mask hidden = once & ~twice;
+            while (hidden) {
+                unsigned int value = ctz(hidden);
+                hidden &= hidden - 1;
+                for (unsigned int i = 0; i < size; ++i) {
+                    unsigned int cell = members[i];
+                    if (l.candidates[cell] & (1u << value)) {
+                        if (!place(g, l, cell, value, stack, num_singles))
+                            return false;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!num_singles)
+            break;
+    }
+
+    // Branch on the empty cell with the fewest candidates.
+    branch_cell = num_cells;
+    unsigned int branch_count = size + 1;
+    for (unsigned int cell = 0; cell < num_cells; ++cell) {
+        Mask candidates = l.candidates[cell];
+        if (!candidates)
+            continue;
+        unsigned int count = popcount(candidates);
+        if (count < branch_count) {
+            branch_count = count;
+            branch_cell = cell;
+            if (count == 2)
+                break;
+        }
+    }
+    return true;
+}
+
+template <class Geometry>
+bool BitmaskSolver::place(const Geometry& g, const Level<typename Geometry::Mask>& l,
+        unsigned int cell, unsigned int value, unsigned short* singles,
+        unsigned int& num_singles) {
+
+    typedef typename Geometry::Mask Mask;
+    const unsigned int num_peers = g.num_peers();
+    const unsigned short* units = &cell_units[cell * 3];
+    Mask bit = static_cast<Mask>(1u << value);
+
+    l.used[units[0]] |= bit;
+    l.used[units[1]] |= bit;
+    l.used[units[2]] |= bit;
+    l.cells[cell] = static_cast<unsigned char>(value);
+    l.candidates[cell] = 0;
+
+    // Remove the value from the peers candidates.
+    const unsigned short* peers = &cell_peers[cell * num_peers];
+    for (unsigned int i = 0; i < num_peers; ++i) {
+        unsigned int peer = peers[i];
+        Mask candidates = l.candidates[peer];
+        if (!(candidates & bit))
+            continue;
+
+        candidates &= ~bit;
+        l.candidates[peer] = candidates;
+        if (!candidates)
+            return false;
+        if (!(candidates & (candidates - 1)))
+            singles[num_singles++] = peer;
+    }
+    return true;
+}
@@ -0,0 +1,180 @@
+//! \file
+//! \brief BitmaskSolver interface.
+//! \author Mathieu Turcotte
+
+#ifndef BITMASK_SOLVER_H_
+#define BITMASK_SOLVER_H_
+
+#include <vector>
+#include <type_traits>
+#include <stdint.h>
+
+#include "SudokuSolver.hpp"
+
+//! \brief Sudoku solver based on constraint propagation.
+//!
+//! The candidates of each cell and the values used by each row, column
+//! and region are kept as bitmasks (16 bits for grids up to 16x16, 32 bits
+//! up to 25x25). Naked and hidden singles are placed until nothing changes,
+//! then the search branches on the empty cell with the fewest candidates.
+//!
+//! The search is instantiated for the 2x2, 2x3, 3x2, 3x3, 4x4 and 5x5
+//! region sizes, whose grid size, cell count and peer count are compile
+//! time constants: the loops get fixed trip counts and the compiler can
+//! unroll them. Other geometries take the generic path, which reads them
+//! at run time.
+class BitmaskSolver: public SudokuSolver {
+public:
+    //! \brief BitmaskSolver constructor.
+    //! \param specialized False to always take the generic path, to
+    //!                    measure what the instantiations bring.
+    explicit BitmaskSolver(bool specialized = true);
+
+    //! \brief Solve a sudoku grid.
+    //! \param[out] s The sudoku grid to solve.
+    //! \return True if the grid was solved, false otherwise.
+    //!
+    //! The grid won't be modified if no solution are found.
+    bool solve(Sudoku& s);
+
+protected:
+    //! \brief Marker for an empty cell in the search grids.
+    static const unsigned char empty = 0xFF;
+
+    //! \brief Search level: views into the storage of one level.
+    template <typename Mask>
+    struct Level {
+        unsigned char* cells;   /**< Cell values, empty if not set. */
+        Mask* candidates;       /**< Candidates of each empty cell, 0 for set cells. */
+        Mask* used;             /**< Values used by each row, column and region. */
+    };
+
+    //! \brief Geometry known at compile time.
+    //! \tparam Rows Vertical size of a region.
+    //! \tparam Cols Horizontal size of a region.
+    template <unsigned short Rows, unsigned short Cols>
+    struct FixedGeometry {
+        typedef typename std::conditional<Rows * Cols <= 16,
+                uint16_t, uint32_t>::type Mask;
+
+        explicit FixedGeometry(const BitmaskSolver&) {
+        }
+
+        static constexpr unsigned int size() {
+            return Rows * Cols;
+        }
+
+        static constexpr unsigned int num_cells() {
+            return Rows * Cols * Rows * Cols;
+        }
+
+        static constexpr unsigned int num_peers() {
+            return 2 * (Rows * Cols - 1) + (Rows - 1) * (Cols - 1);
+        }
+
+        static constexpr unsigned int num_masks() {
+            return num_cells() + size() * 3;
+        }
+    };
+
+    //! \brief Geometry read from the solver at run time.
+    //! \tparam MaskType The mask type, wide enough for the grid size.
+    template <typename MaskType>
+    struct DynamicGeometry {
+        typedef MaskType Mask;
+
+        explicit DynamicGeometry(const BitmaskSolver& solver):
+            size_(solver.grid_size), num_cells_(solver.num_cells),
+            num_peers_(solver.num_peers) {
+        }
+
+        unsigned int size() const {
+            return size_;
+        }
+
+        unsigned int num_cells() const {
+            return num_cells_;
+        }
+
+        unsigned int num_peers() const {
+            return num_peers_;
+        }
+
+        unsigned int num_masks() const {
+            return num_cells_ + size_ * 3;
+        }
+
+        unsigned int size_;         /**< Grid size. */
+        unsigned int num_cells_;    /**< Number of cells. */
+        unsigned int num_peers_;    /**< Number of peers of each cell. */
+    };
+
+    //! \brief Precompute the unit and peer tables of a grid geometry.
+    //! \param s A sudoku grid giving the geometry.
+    void set_geometry(const Sudoku& s);
+
+    //! \brief Solve a grid of a given geometry.
+    //! \tparam Geometry FixedGeometry or DynamicGeometry.
+    //! \param[out] s The sudoku grid to solve.
+    //! \param[out] masks Storage for the masks of each search level.
+    //! \return True if the grid was solved, false otherwise.
+    template <class Geometry>
+    bool solve(Sudoku& s, std::vector<typename Geometry::Mask>& masks);
+
+    //! \brief Get the views into the storage of a search level.
+    template <class Geometry>
+    Level<typename Geometry::Mask> level(const Geometry& g, unsigned int depth,
+            std::vector<typename Geometry::Mask>& masks);
+
+    //! \brief Search from a given level.
+    //! \param g The grid geometry.
+    //! \param depth The search level.
+    //! \param masks Storage for the masks of each search level.
+    //! \return True if a solution was found, false otherwise.
+    //! \post On success, the grid of the given level holds the solution.
+    template <class Geometry>
+    bool search(const Geometry& g, unsigned int depth,
+                std::vector<typename Geometry::Mask>& masks);
+
+    //! \brief Place singles until no more progress is made.
+    //! \param g The grid geometry.
+    //! \param l The current level.
+    //! \param[out] branch_cell The empty cell with the fewest candidates.
+    //! \return False if the grid has no solution.
+    //! \post branch_cell equals the number of cells if the grid is full.
+    template <class Geometry>
+    bool propagate(const Geometry& g, const Level<typename Geometry::Mask>& l,
+                   unsigned int& branch_cell);
+
+    //! \brief Place a value in a cell and remove it from the cell peers.
+    //! \param g The grid geometry.
+    //! \param l The current level.
+    //! \param cell The cell index.
+    //! \param value The value to place.
+    //! \param[in,out] singles Stack of cells left with one candidate.
+    //! \param[in,out] num_singles Number of cells in the stack.
+    //! \return False if a peer is left without candidate.
+    template <class Geometry>
+    bool place(const Geometry& g, const Level<typename Geometry::Mask>& l,
+               unsigned int cell, unsigned int value,
+               unsigned short* singles, unsigned int& num_singles);
+
+    bool specialized;               /**< False to always take the generic path. */
+
+    unsigned short grid_size;       /**< Size of the current geometry. */
+    unsigned short region_num_row;  /**< Vertical size of a region. */
+    unsigned short region_num_col;  /**< Horizontal size of a region. */
+    unsigned int num_cells;         /**< Number of cells in the grid. */
+    unsigned int num_peers;         /**< Number of peers of each cell. */
+
+    std::vector<unsigned short> cell_units;  /**< Row, column and region unit of each cell. */
+    std::vector<unsigned short> unit_cells;  /**< Cells of each unit, size per unit. */
+    std::vector<unsigned short> cell_peers;  /**< Cells sharing a unit with each cell, num_peers per cell. */
+    std::vector<unsigned short> singles;     /**< Stack of the cells left with a single candidate. */
+
+    std::vector<unsigned char> grids;   /**< Grid of each search level, num_cells per level. */
+    std::vector<uint16_t> masks16;      /**< Masks of each level, grids up to 16x16. */
+    std::vector<uint32_t> masks32;      /**< Masks of each level, bigger grids. */
+};
+
+#endif // BITMASK_SOLVER_H_
@@ -0,0 +1,106 @@
+//! \file
+//! \brief CachingSolver implementation.
+//! \author Mathieu Turcotte
+
+#include <chrono>
+
+#include "CachingSolver.hpp"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+CachingSolver::CachingSolver(std::size_t capacity, SudokuSolver* solver):
+    capacity(capacity), solver(solver ? solver : new DancingLinksSolver),
+    cell_bytes(0) {
+}
+
+bool CachingSolver::solve(Sudoku& s) {
+    Clock::time_point start = Clock::now();
+    if (capacity == 0 || !canonicalizer.canonicalize(s, canonical, transform)) {
+        stats.skipped++;
+        stats.lookup_seconds += seconds_since(start);
+        return solver->solve(s);
+    }
+
+    uint64_t hash = Canonicalizer::hash(canonical);
+    std::size_t num_cells = canonical.size() * canonical.size();
+    const char* puzzle = reinterpret_cast<const char*>(canonical.data());
+
+    std::unordered_map<uint64_t, EntryList::iterator>::iterator found = index.find(hash);
+    if (found != index.end() && found->second->puzzle.compare(0, std::string::npos, puzzle, num_cells) == 0) {
+        // Hit: move the entry to the front and map its solution back.
+        EntryList::iterator entry = found->second;
+        entries.splice(entries.begin(), entries, entry);
+        stats.hits++;
+        bool solved = !entry->solution.empty();
+        if (solved) {
+            for (std::size_t i = 0; i < num_cells; ++i)
+                canonical.set_at(i, static_cast<unsigned char>(entry->solution[i]));
+            transform.revert(canonical, s);
+        }
+        stats.lookup_seconds += seconds_since(start);
+        return solved;
+    }
+    stats.misses++;
+    stats.lookup_seconds += seconds_since(start);
+
+    // Solve the grid as given: the canonical order of rows, columns and
+    // values can make the search much longer. Its solution is cached in
+    // canonical form.
+    std::string canonical_puzzle(puzzle, num_cells);
+    bool solved = solver->solve(s);
+    if (solved)
+        transform.apply(s, canonical);
+
+    // Another grid with the same hash gives way.
+    if (found != index.end()) {
+        cell_bytes -= found->second->puzzle.size() + found->second->solution.size();
+        entries.erase(found->second);
+        index.erase(found);
+    } else if (entries.size() >= capacity) {
+        Entry& last = entries.back();
+        cell_bytes -= last.puzzle.size() + last.solution.size();
+        index.erase(last.hash);
+        entries.pop_back();
+        stats.evictions++;
+    }
+
+    entries.push_front(Entry());
+    Entry& entry = entries.front();
+    entry.hash = hash;
+    entry.puzzle.swap(canonical_puzzle);
+    if (solved)
+        entry.solution.assign(reinterpret_cast<const char*>(canonical.data()), num_cells);
+    cell_bytes += entry.puzzle.size() + entry.solution.size();
+    index[hash] = entries.begin();
+    update_sizes();
+    return solved;
+}
+
+void CachingSolver::clear() {
+    entries.clear();
+    index.clear();
+    cell_bytes = 0;
+    update_sizes();
+}
+
+const CacheStats& CachingSolver::cache_stats() const {
+    return stats;
+}
+
+void CachingSolver::update_sizes() {
+    // A list node holds an entry and two links, a map node a key, an
+    // iterator and a link, and the map has an array of buckets.
+    stats.entries = entries.size();
+    stats.memory_bytes = cell_bytes +
+            entries.size() * (sizeof(Entry) + 2 * sizeof(void*)) +
+            index.size() * (sizeof(uint64_t) + sizeof(EntryList::iterator) + sizeof(void*)) +
+            index.bucket_count() * sizeof(void*);
+}
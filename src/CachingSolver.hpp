@@ -0,0 +1,114 @@
+//! \file
+//! \brief CachingSolver interface.
+//! \author Mathieu Turcotte
+
+#ifndef CACHING_SOLVER_H_
+#define CACHING_SOLVER_H_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "SudokuSolver.hpp"
+#include "Canonicalizer.hpp"
+
+//! \brief Solution cache counters.
+//!
+//! Counters of several caches, possibly used on different threads, are
+//! summed with operator+=, the sizes included.
+struct CacheStats {
+    unsigned long long hits;        /**< Grids found in the cache. */
+    unsigned long long misses;      /**< Grids solved and added to the cache. */
+    unsigned long long skipped;     /**< Grids without canonical form, solved directly. */
+    unsigned long long evictions;   /**< Least recently used entries dropped. */
+    double lookup_seconds;          /**< Time spent canonicalizing and looking up. */
+    std::size_t entries;            /**< Entries in the cache. */
+    std::size_t memory_bytes;       /**< Approximate memory used by the entries. */
+
+    //! \brief CacheStats constructor (all counters 0).
+    CacheStats(): hits(0), misses(0), skipped(0), evictions(0),
+        lookup_seconds(0), entries(0), memory_bytes(0) {
+    }
+
+    //! \brief Add the counters of another cache.
+    CacheStats& operator+=(const CacheStats& rhs) {
+        hits += rhs.hits;
+        misses += rhs.misses;
+        skipped += rhs.skipped;
+        evictions += rhs.evictions;
+        lookup_seconds += rhs.lookup_seconds;
+        entries += rhs.entries;
+        memory_bytes += rhs.memory_bytes;
+        return *this;
+    }
+
+    //! \brief Get the share of solved grids found in the cache.
+    //!
+    //! Grids which skipped the cache count as not found.
+    double hit_rate() const {
+        unsigned long long solves = hits + misses + skipped;
+        return solves ? static_cast<double>(hits) / solves : 0;
+    }
+};
+
+//! \brief Solver remembering the solutions of the grids it solved.
+//!
+//! Grids are looked up by their canonical form (see Canonicalizer), so a
+//! grid equivalent to one solved before, up to relabeling, row and column
+//! permutations and transposition, is answered without searching: the
+//! cached canonical solution is mapped back through the grid own
+//! transformation. The cache holds a bounded number of entries and drops
+//! the least recently used one when full. Unsolvable grids are cached too.
+//!
+//! Grids with several solutions may get any of them. The cache isn't
+//! shared: like any solver, one instance serves one thread.
+class CachingSolver: public SudokuSolver {
+public:
+    //! \brief CachingSolver constructor.
+    //! \param capacity Largest number of entries.
+    //! \param solver The solver of the grids not found in the cache, which
+    //!        the cache then owns. A DancingLinksSolver if null.
+    explicit CachingSolver(std::size_t capacity = 65536, SudokuSolver* solver = 0);
+
+    CachingSolver(const CachingSolver&) = delete;
+    CachingSolver& operator=(const CachingSolver&) = delete;
+
+    //! \brief Solve a sudoku grid, from the cache if possible.
+    //! \param[out] s The sudoku grid to solve.
+    //! \return True if the grid was solved, false otherwise.
+    bool solve(Sudoku& s);
+
+    //! \brief Drop every entry. The counters are kept.
+    void clear();
+
+    //! \brief Get the cache counters since the solver was created.
+    const CacheStats& cache_stats() const;
+
+protected:
+    //! \brief A solved grid, in canonical form.
+    struct Entry {
+        uint64_t hash;          /**< Hash of the canonical grid. */
+        std::string puzzle;     /**< Canonical grid cells (see Sudoku::data). */
+        std::string solution;   /**< Canonical solution cells, empty if unsolvable. */
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    //! \brief Update the size counters.
+    void update_sizes();
+
+    std::size_t capacity;                   /**< Largest number of entries. */
+    std::unique_ptr<SudokuSolver> solver;   /**< Solver of the cache misses. */
+    Canonicalizer canonicalizer;            /**< Canonical form of the grids. */
+    Sudoku canonical;                       /**< Canonical form of the grid being solved. */
+    GridTransform transform;                /**< Transformation into the canonical form. */
+    EntryList entries;                      /**< Entries, most recently used first. */
+    std::unordered_map<uint64_t, EntryList::iterator> index;   /**< Entries by hash. */
+    std::size_t cell_bytes;                 /**< Bytes of cells held by the entries. */
+    CacheStats stats;                       /**< Cache counters. */
+};
+
+#endif // CACHING_SOLVER_H_
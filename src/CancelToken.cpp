@@ -0,0 +1,37 @@
+//! \file
+//! \brief CancelToken implementation.
+//! \author Mathieu Turcotte
+
+#include "CancelToken.hpp"
+
+CancelToken::CancelToken(): cancel_flag(false), has_deadline(false) {
+}
+
+void CancelToken::cancel() {
+    cancel_flag.store(true);
+}
+
+void CancelToken::set_deadline(Clock::time_point deadline) {
+    this->deadline = deadline;
+    has_deadline = true;
+}
+
+void CancelToken::set_timeout(Clock::duration timeout) {
+    set_deadline(Clock::now() + timeout);
+}
+
+bool CancelToken::cancelled() const {
+    return cancel_flag.load();
+}
+
+bool CancelToken::expired() const {
+    return has_deadline && Clock::now() >= deadline;
+}
+
+bool CancelToken::stop_requested() const {
+    return cancelled() || expired();
+}
+
+const std::atomic<bool>* CancelToken::flag() const {
+    return &cancel_flag;
+}
@@ -0,0 +1,60 @@
+//! \file
+//! \brief CancelToken interface.
+//! \author Mathieu Turcotte
+
+#ifndef CANCEL_TOKEN_H_
+#define CANCEL_TOKEN_H_
+
+#include <atomic>
+#include <chrono>
+
+//! \brief Cooperative cancellation of a search, with an optional deadline.
+//!
+//! The thread running the search polls the token; any other thread may
+//! cancel it. The deadline is set before the search starts and is
+//! checked between slices of the search, the cancellation as soon as
+//! the search backtracks.
+class CancelToken {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    //! \brief CancelToken constructor (not cancelled, no deadline).
+    CancelToken();
+
+    CancelToken(const CancelToken&) = delete;
+    CancelToken& operator=(const CancelToken&) = delete;
+
+    //! \brief Cancel the search, from any thread.
+    void cancel();
+
+    //! \brief Stop the search at a given time.
+    //! \param deadline The time after which the search is abandoned.
+    void set_deadline(Clock::time_point deadline);
+
+    //! \brief Stop the search after a given time from now.
+    //! \param timeout The time the search is allowed to run.
+    void set_timeout(Clock::duration timeout);
+
+    //! \brief Query whether cancel was called.
+    //! \return True once the token is cancelled.
+    bool cancelled() const;
+
+    //! \brief Query whether the deadline has passed.
+    //! \return True if a deadline is set and has passed.
+    bool expired() const;
+
+    //! \brief Query whether the search should stop.
+    //! \return True if the token is cancelled or has expired.
+    bool stop_requested() const;
+
+    //! \brief Get the flag raised by cancel.
+    //! \return The flag, suitable for BasicDancingLinksSolver::set_stop_flag.
+    const std::atomic<bool>* flag() const;
+
+protected:
+    std::atomic<bool> cancel_flag;  /**< Raised by cancel. */
+    bool has_deadline;              /**< True if deadline is set. */
+    Clock::time_point deadline;     /**< Time after which the search stops. */
+};
+
+#endif // CANCEL_TOKEN_H_
@@ -0,0 +1,240 @@
+//! \file
+//! \brief CandidateEngine implementation.
+//! \author Mathieu Turcotte
+
+#include "CandidateEngine.hpp"
+
+namespace {
+
+//! \brief Count the bits set in a mask.
+inline unsigned int popcount(uint32_t mask) {
+#if defined(__GNUC__)
+    return __builtin_popcount(mask);
+#else
+    unsigned int count = 0;
+    for (; mask; mask &= mask - 1)
+        count++;
+    return count;
+#endif
+}
+
+//! \brief Get the index of the lowest bit set in a mask.
+//! \pre The mask is not 0.
+inline unsigned int ctz(uint32_t mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    unsigned int index = 0;
+    for (; !(mask & 1); mask >>= 1)
+        index++;
+    return index;
+#endif
+}
+
+} // namespace
+
+CandidateEngine::CandidateEngine(const Sudoku& s): s(s) {
+    reset(s);
+}
+
+void CandidateEngine::reset(const Sudoku& s) {
+    this->s = s;
+    size = s.size();
+    all_values = (uint32_t(1) << size) - 1;
+    unsigned int num_cells = size * size;
+    cand.assign(num_cells, 0);
+    held.assign(3 * size, 0);
+    holders.assign(3 * size * size, 0);
+    places.assign(3 * size * size, 0);
+
+    // Every empty cell starts without candidate, refresh fixes the count.
+    num_dead_cells = 0;
+    for (unsigned int index = 0; index < num_cells; ++index) {
+        unsigned char value = s.at(index);
+        if (value == Sudoku::empty) {
+            num_dead_cells++;
+            continue;
+        }
+        unsigned int unit[3];
+        units_of(index, unit);
+        for (unsigned int k = 0; k < 3; ++k) {
+            holders[unit[k] * size + value]++;
+            held[unit[k]] |= uint32_t(1) << value;
+        }
+    }
+    for (unsigned int index = 0; index < num_cells; ++index)
+        refresh(index);
+}
+
+void CandidateEngine::set(unsigned short row, unsigned short col, unsigned char value) {
+    unsigned int index = row * size + col;
+    unsigned char old = s.at(index);
+    if (old == value)
+        return;
+
+    unsigned int unit[3];
+    units_of(index, unit);
+
+    // Take the cell out of the place counts, it goes back in once its
+    // candidates are recomputed.
+    for (uint32_t values = cand[index]; values != 0; values &= values - 1) {
+        unsigned int v = ctz(values);
+        for (unsigned int k = 0; k < 3; ++k)
+            places[unit[k] * size + v]--;
+    }
+    if (old == Sudoku::empty && cand[index] == 0)
+        num_dead_cells--;
+    cand[index] = 0;
+
+    for (unsigned int k = 0; k < 3; ++k) {
+        if (old != Sudoku::empty && --holders[unit[k] * size + old] == 0)
+            held[unit[k]] &= ~(uint32_t(1) << old);
+        if (value != Sudoku::empty) {
+            holders[unit[k] * size + value]++;
+            held[unit[k]] |= uint32_t(1) << value;
+        }
+    }
+    s.set_at(index, value);
+    if (value == Sudoku::empty)
+        num_dead_cells++;
+    refresh(index);
+
+    // Only the old and the new value of the peers can change: go over the
+    // row, the column, then the rest of the region.
+    unsigned int region_row = row / s.region_num_rows() * s.region_num_rows();
+    unsigned int region_col = col / s.region_num_columns() * s.region_num_columns();
+    for (unsigned int i = 0; i < size; ++i) {
+        if (i != col)
+            refresh(row * size + i);
+        if (i != row)
+            refresh(i * size + col);
+    }
+    for (unsigned int r = region_row; r < region_row + s.region_num_rows(); ++r) {
+        for (unsigned int c = region_col; c < region_col + s.region_num_columns(); ++c) {
+            if (r != row && c != col)
+                refresh(r * size + c);
+        }
+    }
+}
+
+uint32_t CandidateEngine::candidates(unsigned short row, unsigned short col) const {
+    return cand[row * size + col];
+}
+
+unsigned int CandidateEngine::num_candidates(unsigned short row, unsigned short col) const {
+    return popcount(cand[row * size + col]);
+}
+
+bool CandidateEngine::is_dead_end() const {
+    if (num_dead_cells != 0)
+        return true;
+    for (unsigned int u = 0; u < 3 * size; ++u) {
+        for (uint32_t missing = all_values & ~held[u]; missing != 0; missing &= missing - 1) {
+            if (places[u * size + ctz(missing)] == 0)
+                return true;
+        }
+    }
+    return false;
+}
+
+bool CandidateEngine::find_dead_end(DeadEnd& dead_end) const {
+    unsigned int num_cells = size * size;
+    if (num_dead_cells != 0) {
+        for (unsigned int index = 0; index < num_cells; ++index) {
+            if (s.at(index) == Sudoku::empty && cand[index] == 0) {
+                dead_end.kind = DeadEnd::no_candidate;
+                dead_end.cell = index;
+                return true;
+            }
+        }
+    }
+    for (unsigned int u = 0; u < 3 * size; ++u) {
+        for (uint32_t missing = all_values & ~held[u]; missing != 0; missing &= missing - 1) {
+            unsigned int v = ctz(missing);
+            if (places[u * size + v] == 0) {
+                dead_end.kind = DeadEnd::no_place;
+                dead_end.unit = u;
+                dead_end.value = v;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool CandidateEngine::find_hint(Hint& hint) const {
+    unsigned int num_cells = size * size;
+    for (unsigned int index = 0; index < num_cells; ++index) {
+        if (cand[index] != 0 && (cand[index] & (cand[index] - 1)) == 0) {
+            hint.cell = index;
+            hint.value = ctz(cand[index]);
+            hint.hidden = false;
+            return true;
+        }
+    }
+    for (unsigned int u = 0; u < 3 * size; ++u) {
+        for (uint32_t missing = all_values & ~held[u]; missing != 0; missing &= missing - 1) {
+            unsigned int v = ctz(missing);
+            if (places[u * size + v] != 1)
+                continue;
+            for (unsigned int i = 0; i < size; ++i) {
+                unsigned int index = cell_of(u, i);
+                if (cand[index] & (uint32_t(1) << v)) {
+                    hint.cell = index;
+                    hint.value = v;
+                    hint.hidden = true;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+const Sudoku& CandidateEngine::grid() const {
+    return s;
+}
+
+void CandidateEngine::units_of(unsigned int index, unsigned int unit[3]) const {
+    unsigned int row = index / size;
+    unsigned int col = index % size;
+    unit[0] = row;
+    unit[1] = size + col;
+    unit[2] = 2 * size + row / s.region_num_rows() * s.region_num_rows()
+            + col / s.region_num_columns();
+}
+
+unsigned int CandidateEngine::cell_of(unsigned int unit, unsigned int i) const {
+    if (unit < size)
+        return unit * size + i;
+    if (unit < 2 * size)
+        return i * size + unit - size;
+    unsigned int rows = s.region_num_rows();
+    unsigned int cols = s.region_num_columns();
+    unsigned int region = unit - 2 * size;
+    return (region / rows * rows + i / cols) * size + region % rows * cols + i % cols;
+}
+
+void CandidateEngine::refresh(unsigned int index) {
+    if (s.at(index) != Sudoku::empty)
+        return;
+
+    unsigned int unit[3];
+    units_of(index, unit);
+    uint32_t values = all_values & ~(held[unit[0]] | held[unit[1]] | held[unit[2]]);
+    uint32_t changed = values ^ cand[index];
+    if (changed == 0)
+        return;
+
+    for (; changed != 0; changed &= changed - 1) {
+        unsigned int v = ctz(changed);
+        int delta = (values >> v) & 1 ? 1 : -1;
+        for (unsigned int k = 0; k < 3; ++k)
+            places[unit[k] * size + v] += delta;
+    }
+    if (cand[index] == 0)
+        num_dead_cells--;
+    if (values == 0)
+        num_dead_cells++;
+    cand[index] = values;
+}
@@ -0,0 +1,119 @@
+//! \file
+//! \brief CandidateEngine interface.
+//! \author Mathieu Turcotte
+
+#ifndef CANDIDATE_ENGINE_H_
+#define CANDIDATE_ENGINE_H_
+
+#include <vector>
+#include <stdint.h>
+
+#include "Sudoku.hpp"
+
+//! \brief A cell or a unit the puzzle can't be completed from.
+struct DeadEnd {
+    //! \brief Kind of dead end.
+    enum Kind {
+        no_candidate,   /**< An empty cell has no candidate left. */
+        no_place        /**< A value has no place left in a unit. */
+    };
+
+    Kind kind;              /**< Kind of dead end. */
+    unsigned int cell;      /**< Index of the empty cell, for no_candidate. */
+    unsigned int unit;      /**< Row, column or region, for no_place. */
+    unsigned char value;    /**< The value, for no_place. */
+};
+
+//! \brief A value which must go in a cell.
+struct Hint {
+    unsigned int cell;      /**< Index of the cell (row * size + column). */
+    unsigned char value;    /**< The value. */
+    bool hidden;            /**< True if the cell is the only place of the
+                                 value in a unit, false if the value is the
+                                 only candidate of the cell. */
+};
+
+//! \brief Candidates of the cells of a grid, kept up to date as the grid
+//!        is edited one cell at a time.
+//!
+//! The candidates of an empty cell are the values none of its peers hold,
+//! one bit per value. Each row, column and region counts how many of its
+//! cells hold each value, and how many of its empty cells accept each
+//! value. Setting or clearing a cell only changes the candidates of its
+//! peers for the old and the new value, so an edit costs O(size) whatever
+//! the grid, and dead ends and forced moves are found from the counts.
+//!
+//! Units are numbered as rows, then columns, then regions, left to right
+//! and top to bottom.
+class CandidateEngine {
+public:
+    //! \brief CandidateEngine constructor.
+    //! \param s The grid to follow.
+    explicit CandidateEngine(const Sudoku& s);
+
+    //! \brief Follow another grid.
+    //! \param s The grid, which may have another geometry.
+    void reset(const Sudoku& s);
+
+    //! \brief Set a cell of the followed grid.
+    //! \param row The cell row.
+    //! \param col The cell column.
+    //! \param value The cell value, or Sudoku::empty to clear the cell.
+    //! \pre The value is below the grid size, or empty.
+    void set(unsigned short row, unsigned short col, unsigned char value);
+
+    //! \brief Get the candidates of a cell.
+    //! \param row The cell row.
+    //! \param col The cell column.
+    //! \return The values no peer holds, bit v standing for value v, or 0
+    //!         if the cell is set.
+    uint32_t candidates(unsigned short row, unsigned short col) const;
+
+    //! \brief Get the number of candidates of a cell.
+    //! \param row The cell row.
+    //! \param col The cell column.
+    //! \return The number of candidates, 0 if the cell is set.
+    unsigned int num_candidates(unsigned short row, unsigned short col) const;
+
+    //! \brief Query whether the grid obviously can't be completed.
+    //! \return True if an empty cell has no candidate, or a row, column or
+    //!         region has no place left for one of its missing values.
+    bool is_dead_end() const;
+
+    //! \brief Find why the grid can't be completed.
+    //! \param[out] dead_end The first cell without candidate, or else the
+    //!             first unit without place for a value.
+    //! \return True if a dead end was found.
+    bool find_dead_end(DeadEnd& dead_end) const;
+
+    //! \brief Find a forced move.
+    //! \param[out] hint The first cell with a single candidate, or else
+    //!             the first value with a single place in a unit.
+    //! \return True if a forced move was found.
+    bool find_hint(Hint& hint) const;
+
+    //! \brief Get the followed grid.
+    const Sudoku& grid() const;
+
+protected:
+    //! \brief Get the units of a cell: its row, column and region.
+    void units_of(unsigned int index, unsigned int unit[3]) const;
+
+    //! \brief Get the i-th cell of a unit.
+    unsigned int cell_of(unsigned int unit, unsigned int i) const;
+
+    //! \brief Recompute the candidates of a cell from the unit counts and
+    //!        update the place counts of its units.
+    void refresh(unsigned int index);
+
+    Sudoku s;                       /**< The followed grid. */
+    unsigned int size;              /**< Grid size. */
+    uint32_t all_values;            /**< Mask of the values of the grid. */
+    unsigned int num_dead_cells;    /**< Empty cells without candidate. */
+    std::vector<uint32_t> cand;     /**< Candidates of each cell, 0 if set. */
+    std::vector<uint32_t> held;     /**< Values held in each unit. */
+    std::vector<unsigned char> holders; /**< Cells of each unit holding each value. */
+    std::vector<unsigned char> places;  /**< Empty cells of each unit accepting each value. */
+};
+
+#endif // CANDIDATE_ENGINE_H_
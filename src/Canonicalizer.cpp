@@ -0,0 +1,328 @@
+//! \file
+//! \brief Canonicalizer implementation.
+//! \author Mathieu Turcotte
+
+#include <algorithm>
+
+#include "Canonicalizer.hpp"
+
+namespace {
+
+//! \brief Mix a value into a hash (splitmix64 finalizer).
+inline uint64_t mix(uint64_t hash, uint64_t value) {
+    uint64_t z = hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+//! \brief Hash a multiset of values.
+//! \param values The values, sorted in place.
+//! \param n The number of values.
+inline uint64_t mix_sorted(uint64_t hash, uint64_t* values, unsigned int n) {
+    std::sort(values, values + n);
+    for (unsigned int i = 0; i < n; ++i)
+        hash = mix(hash, values[i]);
+    return hash;
+}
+
+//! \brief List the orders of some items which keep them sorted by key.
+//! \param items The items, sorted in place by key then by item.
+//! \param n The number of items, at most 25.
+//! \param keys The key of every item, indexed by item.
+//! \param max_orders Largest number of orders to list.
+//! \param[out] orders Receives the orders, one after the other, starting
+//!             with the sorted items.
+//! \return The number of orders, 0 if there are more than max_orders.
+std::size_t list_tie_orders(unsigned char* items, unsigned int n, const uint64_t* keys,
+                            std::size_t max_orders, std::vector<unsigned char>& orders) {
+    // Insertion sort: there are a few items, mostly in order.
+    for (unsigned int i = 1; i < n; ++i) {
+        unsigned char item = items[i];
+        unsigned int j = i;
+        for (; j > 0 && (keys[items[j - 1]] > keys[item] ||
+                (keys[items[j - 1]] == keys[item] && items[j - 1] > item)); --j)
+            items[j] = items[j - 1];
+        items[j] = item;
+    }
+
+    // Runs of equal keys, and the number of orders they give.
+    unsigned int ties[25][2];
+    unsigned int num_ties = 0;
+    std::size_t num_orders = 1;
+    for (unsigned int first = 0; first < n;) {
+        unsigned int last = first + 1;
+        while (last < n && keys[items[last]] == keys[items[first]])
+            last++;
+        if (last - first > 1) {
+            ties[num_ties][0] = first;
+            ties[num_ties++][1] = last;
+        }
+        for (unsigned int k = 2; k <= last - first; ++k) {
+            num_orders *= k;
+            if (num_orders > max_orders)
+                return 0;
+        }
+        first = last;
+    }
+
+    orders.insert(orders.end(), items, items + n);
+
+    // Odometer over the runs: the last run turns first, and a run going
+    // back to its sorted order carries to the previous one.
+    for (unsigned int t = num_ties; t-- > 0;) {
+        if (std::next_permutation(items + ties[t][0], items + ties[t][1])) {
+            orders.insert(orders.end(), items, items + n);
+            t = num_ties;
+        }
+    }
+    return num_orders;
+}
+
+} // namespace
+
+void GridTransform::apply(const Sudoku& in, Sudoku& out) const {
+    if (out.region_size() != in.region_size())
+        out = Sudoku(in.region_num_rows(), in.region_num_columns());
+    unsigned int size = in.size();
+    for (unsigned int r = 0; r < size; ++r) {
+        for (unsigned int c = 0; c < size; ++c) {
+            unsigned int from = transposed ? cols[c] * size + rows[r] : rows[r] * size + cols[c];
+            unsigned char value = in.at(from);
+            out.set_at(r * size + c, value == Sudoku::empty ? value : labels[value]);
+        }
+    }
+}
+
+void GridTransform::revert(const Sudoku& in, Sudoku& out) const {
+    if (out.region_size() != in.region_size())
+        out = Sudoku(in.region_num_rows(), in.region_num_columns());
+    unsigned int size = in.size();
+    unsigned char values[32];
+    for (unsigned int v = 0; v < size; ++v)
+        values[labels[v]] = v;
+    for (unsigned int r = 0; r < size; ++r) {
+        for (unsigned int c = 0; c < size; ++c) {
+            unsigned int to = transposed ? cols[c] * size + rows[r] : rows[r] * size + cols[c];
+            unsigned char value = in.at(r * size + c);
+            out.set_at(to, value == Sudoku::empty ? value : values[value]);
+        }
+    }
+}
+
+Canonicalizer::Canonicalizer(std::size_t max_candidates): max_candidates(max_candidates),
+    size(0), found(false) {
+}
+
+bool Canonicalizer::canonicalize(const Sudoku& s, Sudoku& canonical, GridTransform& transform) {
+    size = s.size();
+    found = false;
+    if (!search(s, false))
+        return false;
+    if (s.region_num_rows() == s.region_num_columns() && !search(s, true))
+        return false;
+
+    if (canonical.region_size() != s.region_size())
+        canonical = Sudoku(s.region_num_rows(), s.region_num_columns());
+    unsigned int num_cells = size * size;
+    for (unsigned int index = 0; index < num_cells; ++index)
+        canonical.set_at(index, best[index] == 0 ? Sudoku::empty : best[index] - 1);
+
+    // The values absent from the grid take the labels left, in order.
+    transform = best_transform;
+    unsigned char next = 0;
+    for (unsigned int v = 0; v < size; ++v) {
+        if (transform.labels[v] != Sudoku::empty)
+            next++;
+    }
+    for (unsigned int v = 0; v < size; ++v) {
+        if (transform.labels[v] == Sudoku::empty)
+            transform.labels[v] = next++;
+    }
+    return true;
+}
+
+uint64_t Canonicalizer::hash(const Sudoku& s) {
+    // FNV-1a.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = (hash ^ s.region_num_rows()) * 0x100000001b3ULL;
+    hash = (hash ^ s.region_num_columns()) * 0x100000001b3ULL;
+    const unsigned char* data = s.data();
+    unsigned int num_cells = s.size() * s.size();
+    for (unsigned int index = 0; index < num_cells; ++index)
+        hash = (hash ^ data[index]) * 0x100000001b3ULL;
+    return hash;
+}
+
+std::size_t Canonicalizer::list_orders(const uint64_t* keys, unsigned int band_size,
+        std::size_t max_orders, std::vector<unsigned char>& orders) {
+    unsigned int num_bands = size / band_size;
+
+    // A band is known by the keys of its rows.
+    uint64_t band_keys[25];
+    uint64_t row_keys[25];
+    for (unsigned int b = 0; b < num_bands; ++b) {
+        std::copy(keys + b * band_size, keys + (b + 1) * band_size, row_keys);
+        band_keys[b] = mix_sorted(band_size, row_keys, band_size);
+    }
+
+    unsigned char items[25];
+    for (unsigned int b = 0; b < num_bands; ++b)
+        items[b] = b;
+    band_orders.clear();
+    std::size_t num_band_orders = list_tie_orders(items, num_bands, band_keys,
+                                                  max_orders, band_orders);
+    if (num_band_orders == 0)
+        return 0;
+
+    // The orders of the rows of band b start at within_orders[first[b]].
+    std::size_t first[25];
+    std::size_t count[25];
+    std::size_t num_orders = num_band_orders;
+    within_orders.clear();
+    for (unsigned int b = 0; b < num_bands; ++b) {
+        for (unsigned int i = 0; i < band_size; ++i)
+            items[i] = b * band_size + i;
+        first[b] = within_orders.size();
+        count[b] = list_tie_orders(items, band_size, keys, max_orders, within_orders);
+        num_orders *= count[b];
+        if (count[b] == 0 || num_orders > max_orders)
+            return 0;
+    }
+
+    // Every band order, with every order of the rows of each band.
+    orders.clear();
+    std::size_t choice[25];
+    for (std::size_t o = 0; o < num_band_orders; ++o) {
+        const unsigned char* band_order = &band_orders[o * num_bands];
+        std::fill(choice, choice + num_bands, 0);
+        for (;;) {
+            for (unsigned int k = 0; k < num_bands; ++k) {
+                unsigned int b = band_order[k];
+                const unsigned char* rows = &within_orders[first[b] + choice[k] * band_size];
+                orders.insert(orders.end(), rows, rows + band_size);
+            }
+            unsigned int k = num_bands;
+            while (k > 0 && ++choice[k - 1] == count[band_order[k - 1]])
+                choice[--k] = 0;
+            if (k == 0)
+                break;
+        }
+    }
+    return num_orders;
+}
+
+bool Canonicalizer::search(const Sudoku& s, bool transposed) {
+    unsigned int num_cells = size * size;
+    cells.resize(num_cells);
+    for (unsigned int r = 0; r < size; ++r) {
+        for (unsigned int c = 0; c < size; ++c) {
+            unsigned char value = transposed ? s.at(c * size + r) : s.at(r * size + c);
+            cells[r * size + c] = value == Sudoku::empty ? 0 : value + 1;
+        }
+    }
+
+    // Invariants of a row: its clue count, and for each clue the clue
+    // count of its column and how often its value is given. Then the
+    // same again with the keys of the columns and rows it crosses.
+    unsigned int row_counts[25] = { 0 };
+    unsigned int col_counts[25] = { 0 };
+    unsigned int frequencies[26] = { 0 };
+    for (unsigned int index = 0; index < num_cells; ++index) {
+        if (cells[index] != 0) {
+            row_counts[index / size]++;
+            col_counts[index % size]++;
+            frequencies[cells[index]]++;
+        }
+    }
+    uint64_t row_keys[25], col_keys[25], values[25];
+    for (unsigned int r = 0; r < size; ++r) {
+        unsigned int n = 0;
+        for (unsigned int c = 0; c < size; ++c) {
+            if (unsigned char v = cells[r * size + c])
+                values[n++] = uint64_t(col_counts[c]) << 32 | frequencies[v];
+        }
+        row_keys[r] = mix_sorted(row_counts[r], values, n);
+    }
+    for (unsigned int c = 0; c < size; ++c) {
+        unsigned int n = 0;
+        for (unsigned int r = 0; r < size; ++r) {
+            if (unsigned char v = cells[r * size + c])
+                values[n++] = uint64_t(row_counts[r]) << 32 | frequencies[v];
+        }
+        col_keys[c] = mix_sorted(col_counts[c], values, n);
+    }
+    uint64_t refined_rows[25], refined_cols[25];
+    for (unsigned int r = 0; r < size; ++r) {
+        unsigned int n = 0;
+        for (unsigned int c = 0; c < size; ++c) {
+            if (cells[r * size + c] != 0)
+                values[n++] = col_keys[c];
+        }
+        refined_rows[r] = mix_sorted(row_keys[r], values, n);
+    }
+    for (unsigned int c = 0; c < size; ++c) {
+        unsigned int n = 0;
+        for (unsigned int r = 0; r < size; ++r) {
+            if (cells[r * size + c] != 0)
+                values[n++] = row_keys[r];
+        }
+        refined_cols[c] = mix_sorted(col_keys[c], values, n);
+    }
+
+    // Transposing requires square regions: bands and stacks have the
+    // same size either way.
+    std::size_t num_row_orders = list_orders(refined_rows, s.region_num_rows(),
+                                             max_candidates, row_orders);
+    if (num_row_orders == 0)
+        return false;
+    std::size_t num_col_orders = list_orders(refined_cols, s.region_num_columns(),
+                                             max_candidates / num_row_orders, col_orders);
+    if (num_col_orders == 0)
+        return false;
+
+    best.resize(num_cells);
+    unsigned char label[26];
+    for (std::size_t i = 0; i < num_row_orders; ++i) {
+        const unsigned char* rows = &row_orders[i * size];
+        for (std::size_t j = 0; j < num_col_orders; ++j) {
+            const unsigned char* cols = &col_orders[j * size];
+
+            // Relabel the values in order of appearance, and compare with
+            // the smallest grid so far until a cell differs. From there on
+            // a smaller grid overwrites it.
+            std::fill(label, label + size + 1, 0);
+            unsigned char next = 1;
+            bool smaller = !found;
+            bool larger = false;
+            for (unsigned int r = 0; r < size && !larger; ++r) {
+                const unsigned char* row = &cells[rows[r] * size];
+                unsigned char* best_row = &best[r * size];
+                for (unsigned int c = 0; c < size; ++c) {
+                    unsigned char v = row[cols[c]];
+                    unsigned char code = v == 0 ? 0 : label[v] != 0 ? label[v] : (label[v] = next++);
+                    if (!smaller) {
+                        if (code > best_row[c]) {
+                            larger = true;
+                            break;
+                        }
+                        smaller = code < best_row[c];
+                    }
+                    if (smaller)
+                        best_row[c] = code;
+                }
+            }
+            if (!smaller)
+                continue;
+
+            found = true;
+            best_transform.transposed = transposed;
+            best_transform.rows.assign(rows, rows + size);
+            best_transform.cols.assign(cols, cols + size);
+            best_transform.labels.resize(size);
+            for (unsigned int v = 0; v < size; ++v)
+                best_transform.labels[v] = label[v + 1] == 0 ? Sudoku::empty : label[v + 1] - 1;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,102 @@
+//! \file
+//! \brief Canonicalizer interface.
+//! \author Mathieu Turcotte
+
+#ifndef CANONICALIZER_H_
+#define CANONICALIZER_H_
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+#include "Sudoku.hpp"
+
+//! \brief A transformation mapping a grid to an equivalent one.
+//!
+//! The grid is first transposed if asked, then cell (r, c) of the result
+//! takes the value of cell (rows[r], cols[c]), relabeled. The row and
+//! column maps only move rows within their band, bands as a whole,
+//! columns within their stack and stacks as a whole, so the result
+//! obeys the same rules as the original.
+struct GridTransform {
+    bool transposed;                    /**< Transpose first, square regions only. */
+    std::vector<unsigned char> rows;    /**< Source row of each row. */
+    std::vector<unsigned char> cols;    /**< Source column of each column. */
+    std::vector<unsigned char> labels;  /**< New value of each value. */
+
+    //! \brief Transform a grid.
+    //! \param in The grid.
+    //! \param[out] out The transformed grid, of the same geometry.
+    void apply(const Sudoku& in, Sudoku& out) const;
+
+    //! \brief Undo the transformation of a grid.
+    //! \param in The transformed grid.
+    //! \param[out] out The grid in, before the transformation.
+    void revert(const Sudoku& in, Sudoku& out) const;
+};
+
+//! \brief Canonical form of grids under the sudoku symmetries.
+//!
+//! Two grids are equivalent if one is the other with its values relabeled,
+//! its rows permuted within bands, its columns within stacks, its bands
+//! and stacks permuted and, for square regions, transposed. The canonical
+//! form of a grid is the smallest of its equivalent grids, comparing cells
+//! in row-major order with empty cells first and values relabeled in order
+//! of appearance, so equivalent grids have the same canonical form.
+//!
+//! Rows and columns are first ordered by invariants of the symmetries
+//! (clue counts of the row and of the columns it crosses, frequency of its
+//! values, then the same for the bands and stacks). Only the orders of
+//! rows and columns left tied are then tried, which is usually a few out
+//! of the 2 * 6^8 transformations of a 9x9 grid. Grids with too many ties,
+//! like nearly empty or nearly full grids, are given up.
+class Canonicalizer {
+public:
+    //! \brief Canonicalizer constructor.
+    //! \param max_candidates Largest number of row and column orders to try
+    //!        before giving a grid up.
+    explicit Canonicalizer(std::size_t max_candidates = 4096);
+
+    //! \brief Compute the canonical form of a grid.
+    //! \param s The grid.
+    //! \param[out] canonical The canonical form, of the same geometry.
+    //! \param[out] transform A transformation of s into its canonical form.
+    //!             The values absent from s are mapped to the largest
+    //!             values, in increasing order.
+    //! \return False if the grid was given up.
+    bool canonicalize(const Sudoku& s, Sudoku& canonical, GridTransform& transform);
+
+    //! \brief Hash a grid.
+    //! \param s The grid, usually a canonical form.
+    //! \return A 64 bits hash of the grid geometry and cells.
+    static uint64_t hash(const Sudoku& s);
+
+protected:
+    //! \brief Order the rows of a grid by their invariants.
+    //! \param keys The key of every row.
+    //! \param band_size The number of rows of a band.
+    //! \param max_orders Largest number of orders to list.
+    //! \param[out] orders Row orders keeping bands, then rows of a band,
+    //!             sorted by key, tied rows and bands in every order, one
+    //!             after the other.
+    //! \return The number of orders, 0 if there are more than max_orders.
+    std::size_t list_orders(const uint64_t* keys, unsigned int band_size,
+                            std::size_t max_orders, std::vector<unsigned char>& orders);
+
+    //! \brief Try every row and column order of an orientation of a grid.
+    //! \return False if the grid was given up.
+    bool search(const Sudoku& s, bool transposed);
+
+    std::size_t max_candidates;         /**< Orders tried before giving a grid up. */
+    unsigned int size;                  /**< Grid size. */
+    std::vector<unsigned char> cells;   /**< The grid, oriented, empty cells as 0 and values from 1. */
+    std::vector<unsigned char> best;    /**< Smallest grid so far, same coding, values relabeled. */
+    bool found;                         /**< True once best holds a grid. */
+    GridTransform best_transform;       /**< Transformation giving best. */
+    std::vector<unsigned char> row_orders;  /**< Row orders to try, one after the other. */
+    std::vector<unsigned char> col_orders;  /**< Column orders to try, one after the other. */
+    std::vector<unsigned char> band_orders; /**< Band orders, while listing row orders. */
+    std::vector<unsigned char> within_orders;   /**< Orders of the rows of each band, while listing row orders. */
+};
+
+#endif // CANONICALIZER_H_
@@ -0,0 +1,224 @@
+//! \file
+//! \brief PuzzleGenerator implementation.
+//! \author Mathieu Turcotte
+
+#include <thread>
+#include <atomic>
+#include <algorithm>    // std::min
+
+#include "Generator.hpp"
+#include "Random.hpp"
+
+namespace {
+
+//! \brief Fill the regions of the diagonal with random permutations.
+//! \param[in,out] s An empty grid.
+void fill_diagonal(Sudoku& s, Random& random) {
+    unsigned int size = s.size();
+    unsigned int rows = s.region_num_rows();
+    unsigned int cols = s.region_num_columns();
+    unsigned int num_regions = std::min(size / rows, size / cols);
+    std::vector<unsigned int> values;
+
+    for (unsigned int region = 0; region < num_regions; ++region) {
+        random.shuffle(values, size);
+        for (unsigned int i = 0; i < rows; ++i) {
+            for (unsigned int j = 0; j < cols; ++j) {
+                s.set_at((region * rows + i) * size + region * cols + j,
+                         values[i * cols + j]);
+            }
+        }
+    }
+}
+
+//! \brief Values seen by the cells of a grid.
+//!
+//! Each row, column and region has the mask of the clues it holds, bit v
+//! standing for value v.
+class SeenValues {
+public:
+    explicit SeenValues(const Sudoku& s): s(s), size(s.size()),
+        rows(s.region_num_rows()), cols(s.region_num_columns()) {
+
+        for (unsigned int i = 0; i < size; ++i)
+            row_seen[i] = col_seen[i] = region_seen[i] = 0;
+        for (unsigned int index = 0; index < size * size; ++index) {
+            unsigned char value = s.at(index);
+            if (value == Sudoku::empty)
+                continue;
+            unsigned int row = index / size;
+            unsigned int col = index % size;
+            row_seen[row] |= 1u << value;
+            col_seen[col] |= 1u << value;
+            region_seen[region(row, col)] |= 1u << value;
+        }
+    }
+
+    //! \brief Get the values left to a blank cell.
+    unsigned int candidates(unsigned int index) const {
+        unsigned int row = index / size;
+        unsigned int col = index % size;
+        return ((1u << size) - 1) &
+                ~(row_seen[row] | col_seen[col] | region_seen[region(row, col)]);
+    }
+
+    //! \brief Query whether the clues force the value of a blank cell.
+    //! \param index The cell index.
+    //! \param value The value of the cell in the grid solution.
+    //! \return True if it is the only value left to the cell, or if no
+    //!         other cell of its row, column or region can take it.
+    bool forced(unsigned int index, unsigned char value) const {
+        unsigned int bit = 1u << value;
+        if (candidates(index) == bit)
+            return true;
+
+        unsigned int row = index / size;
+        unsigned int col = index % size;
+        unsigned int first = (row / rows * rows) * size + col / cols * cols;
+        for (unsigned int unit = 0; unit < 3; ++unit) {
+            bool elsewhere = false;
+            for (unsigned int i = 0; i < size && !elsewhere; ++i) {
+                unsigned int other = unit == 0 ? row * size + i :
+                                     unit == 1 ? i * size + col :
+                                     first + (i / cols) * size + i % cols;
+                elsewhere = other != index && s.at(other) == Sudoku::empty &&
+                        (candidates(other) & bit) != 0;
+            }
+            if (!elsewhere)
+                return true;
+        }
+        return false;
+    }
+
+protected:
+    unsigned int region(unsigned int row, unsigned int col) const {
+        return row / rows * rows + col / cols;
+    }
+
+    const Sudoku& s;            /**< The grid. */
+    unsigned int size;          /**< The grid size. */
+    unsigned int rows;          /**< Region vertical size. */
+    unsigned int cols;          /**< Region horizontal size. */
+    unsigned int row_seen[25];      /**< Clues of each row. */
+    unsigned int col_seen[25];      /**< Clues of each column. */
+    unsigned int region_seen[25];   /**< Clues of each region. */
+};
+
+} // namespace
+
+PuzzleGenerator::PuzzleGenerator(const GeneratorOptions& options)
+    throw(std::logic_error): options(options),
+    empty(options.region_num_row, options.region_num_col) {
+
+    if (this->options.num_threads == 0)
+        this->options.num_threads = std::thread::hardware_concurrency();
+    if (this->options.num_threads == 0)
+        this->options.num_threads = 1;
+
+    for (unsigned int i = 0; i < this->options.num_threads; ++i)
+        solvers.push_back(std::unique_ptr<DancingLinksSolver>(new DancingLinksSolver));
+
+    // Group each cell with its symmetric, the orbits are removed whole.
+    unsigned int size = empty.size();
+    for (unsigned int index = 0; index < size * size; ++index) {
+        unsigned int row = index / size;
+        unsigned int col = index % size;
+        unsigned int other = index;
+        if (options.symmetry == symmetry_rotational)
+            other = size * size - 1 - index;
+        else if (options.symmetry == symmetry_mirror)
+            other = row * size + size - 1 - col;
+
+        if (other < index)
+            continue;
+        orbits.push_back(std::vector<unsigned int>(1, index));
+        if (other != index)
+            orbits.back().push_back(other);
+    }
+}
+
+Sudoku PuzzleGenerator::generate(unsigned long long index) {
+    Sudoku puzzle(empty);
+    generate(index, *solvers[0], puzzle);
+    return puzzle;
+}
+
+void PuzzleGenerator::generate(unsigned long long first, Sudoku* puzzles,
+        std::size_t count) {
+    // Puzzles are dealt a few at a time, their cost varies.
+    const std::size_t batch = 16;
+    std::atomic<std::size_t> next(0);
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < options.num_threads; ++i) {
+        threads.push_back(std::thread([&, i]() {
+            DancingLinksSolver& solver = *solvers[i];
+            for (;;) {
+                std::size_t begin = next.fetch_add(batch);
+                if (begin >= count)
+                    break;
+                std::size_t end = std::min(begin + batch, count);
+                for (std::size_t k = begin; k < end; ++k) {
+                    puzzles[k] = empty;
+                    generate(first + k, solver, puzzles[k]);
+                }
+            }
+        }));
+    }
+    for (std::size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+}
+
+void PuzzleGenerator::generate(unsigned long long index, DancingLinksSolver& solver,
+        Sudoku& puzzle) {
+    Random random(options.seed, index);
+
+    // Complete random diagonal regions into a solved grid. A completion
+    // which takes too long is dropped for other diagonal regions.
+    Sudoku solved(empty);
+    for (;;) {
+        solved = empty;
+        fill_diagonal(solved, random);
+        if (solver.start_search(solved) == DancingLinksSolver::search_suspended &&
+                solver.resume_search(solved, completion_nodes) == DancingLinksSolver::search_solved)
+            break;
+        solver.abort_search();
+    }
+    puzzle = shuffle(solved, random);
+
+    unsigned int num_clues = puzzle.size() * puzzle.size();
+    std::vector<unsigned int> order;
+    random.shuffle(order, orbits.size());
+
+    for (std::size_t i = 0; i < order.size() && num_clues > options.num_clues; ++i) {
+        const std::vector<unsigned int>& orbit = orbits[order[i]];
+        if (num_clues < options.num_clues + orbit.size())
+            continue;
+
+        unsigned char values[2];
+        for (std::size_t k = 0; k < orbit.size(); ++k) {
+            values[k] = puzzle.at(orbit[k]);
+            puzzle.set_at(orbit[k], Sudoku::empty);
+        }
+
+        // The puzzle had a unique solution. Another one, without the
+        // orbit clues, differs from it on a first cell of the orbit:
+        // look for it with the clues before that cell put back. There
+        // is none if the other clues force the cell value, which is the
+        // case of most clues and needs no search.
+        bool unique = true;
+        for (std::size_t k = 0; k < orbit.size() && unique; ++k) {
+            if (!SeenValues(puzzle).forced(orbit[k], values[k]))
+                unique = !solver.has_solution_without(puzzle, orbit[k], values[k]);
+            puzzle.set_at(orbit[k], values[k]);
+        }
+        for (std::size_t k = 0; k < orbit.size(); ++k)
+            puzzle.set_at(orbit[k], values[k]);
+
+        if (unique) {
+            for (std::size_t k = 0; k < orbit.size(); ++k)
+                puzzle.set_at(orbit[k], Sudoku::empty);
+            num_clues -= orbit.size();
+        }
+    }
+}
@@ -0,0 +1,80 @@
+//! \file
+//! \brief PuzzleGenerator interface.
+//! \author Mathieu Turcotte
+
+#ifndef GENERATOR_H_
+#define GENERATOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Sudoku.hpp"
+#include "SudokuSolver.hpp"
+
+//! \brief Symmetry of the clues of a generated puzzle.
+enum Symmetry {
+    symmetry_none,          /**< Clues anywhere. */
+    symmetry_rotational,    /**< Clues unchanged by a half turn of the grid. */
+    symmetry_mirror         /**< Clues unchanged by a left-right reflection. */
+};
+
+//! \brief Generator options.
+struct GeneratorOptions {
+    unsigned short region_num_row;  /**< Region vertical size. */
+    unsigned short region_num_col;  /**< Region horizontal size. */
+    unsigned long seed;             /**< Seed of the puzzle sequence. */
+    unsigned int num_clues;         /**< Clue count to stop at, 0 for minimal puzzles. */
+    Symmetry symmetry;              /**< Symmetry of the clues. */
+    unsigned int num_threads;       /**< Number of threads, 0 for one per core. */
+};
+
+//! \brief Generator of puzzles with a unique solution.
+//!
+//! A puzzle starts from a random solved grid: the regions of the
+//! diagonal, which share no row or column, get random permutations of
+//! the values, the dancing links solver completes the grid, then its
+//! rows, columns and values are shuffled. Clues are then removed in
+//! random order, symmetric clues together, as long as the solution stays
+//! unique (see BasicDancingLinksSolver::has_solution_without), until the
+//! target clue count is reached or no more clue can be removed.
+//!
+//! Puzzle i of a sequence only depends on the seed and on i, so a seed
+//! gives the same puzzles whatever the number of threads.
+class PuzzleGenerator {
+public:
+    //! \brief Number of search nodes allowed to complete a solved grid
+    //!        before starting over from new diagonal regions.
+    static const unsigned long completion_nodes = 100000;
+
+    //! \brief PuzzleGenerator constructor.
+    //! \param options The generator options.
+    explicit PuzzleGenerator(const GeneratorOptions& options) throw(std::logic_error);
+
+    //! \brief Generate a puzzle.
+    //! \param index The puzzle position in the sequence.
+    //! \return The puzzle, with a unique solution.
+    Sudoku generate(unsigned long long index);
+
+    //! \brief Generate consecutive puzzles on several threads.
+    //! \param first The position of the first puzzle in the sequence.
+    //! \param[out] puzzles The puzzles, of the generator geometry.
+    //! \param count The number of puzzles.
+    void generate(unsigned long long first, Sudoku* puzzles, std::size_t count);
+
+protected:
+    //! \brief Generate a puzzle with a given solver.
+    //! \param index The puzzle position in the sequence.
+    //! \param solver The solver checking uniqueness, one per thread.
+    //! \param[out] puzzle The puzzle.
+    void generate(unsigned long long index, DancingLinksSolver& solver,
+                  Sudoku& puzzle);
+
+    GeneratorOptions options;   /**< Generator options. */
+    Sudoku empty;               /**< Empty grid of the generator geometry. */
+    std::vector<std::vector<unsigned int> > orbits;    /**< Cells removed together, by symmetry. */
+    std::vector<std::unique_ptr<DancingLinksSolver> > solvers;  /**< Solver of each thread. */
+};
+
+#endif // GENERATOR_H_
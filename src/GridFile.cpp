@@ -0,0 +1,276 @@
+//! \file
+//! \brief Binary grid file implementation.
+//! \author Mathieu Turcotte
+
+#include <cstring>  // std::memcmp, std::memset
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "GridFile.hpp"
+
+namespace {
+
+const char magic[4] = { 'S', 'D', 'K', 'B' };
+const unsigned char version = 1;
+const unsigned char flag_solutions = 1;
+
+//! \brief Write a little endian 64 bits integer.
+void put_u64(unsigned char* out, unsigned long long value) {
+    for (unsigned int i = 0; i < 8; ++i)
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+//! \brief Read a little endian 64 bits integer.
+unsigned long long get_u64(const unsigned char* in) {
+    unsigned long long value = 0;
+    for (unsigned int i = 0; i < 8; ++i)
+        value |= static_cast<unsigned long long>(in[i]) << (8 * i);
+    return value;
+}
+
+} // namespace
+
+GridView::GridView(const unsigned char* bits, unsigned short grid_size):
+    bits(bits), grid_size(grid_size) {
+}
+
+unsigned short GridView::size() const {
+    return grid_size;
+}
+
+unsigned char GridView::at(unsigned int index) const {
+    unsigned int code;
+    if (GridFile::bits_per_cell(grid_size) == 4) {
+        code = (bits[index / 2] >> (4 * (index % 2))) & 0xF;
+    } else {
+        unsigned int bit = index * 5;
+        code = bits[bit / 8] >> (bit % 8);
+        if (bit % 8 > 3)
+            code |= bits[bit / 8 + 1] << (8 - bit % 8);
+        code &= 0x1F;
+    }
+    return code == 0 ? Sudoku::empty : static_cast<unsigned char>(code - 1);
+}
+
+bool GridView::is_empty() const {
+    std::size_t n = GridFile::packed_size(grid_size);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (bits[i])
+            return false;
+    }
+    return true;
+}
+
+void GridView::copy_to(Sudoku& s) const {
+    unsigned int num_cells = grid_size * grid_size;
+    for (unsigned int i = 0; i < num_cells; ++i)
+        s.set_at(i, at(i));
+}
+
+void GridView::append_to(std::string& out) const {
+    unsigned int num_cells = grid_size * grid_size;
+    for (unsigned int i = 0; i < num_cells; ++i) {
+        unsigned char value = at(i);
+        if (value == Sudoku::empty)
+            out += 'x';
+        else
+            out += static_cast<char>(value < 10 ? '0' + value : 'A' + value - 10);
+    }
+}
+
+GridFile::GridFile(const std::string& path) throw(std::runtime_error):
+    data(0), length(0), mapping(0), num_records(0), record_size(0),
+    region_num_row(0), region_num_col(0), solutions(false) {
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("GridFile::GridFile: cannot open " + path);
+
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        length = static_cast<std::size_t>(file_size.QuadPart);
+        mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+        if (mapping)
+            data = static_cast<const unsigned char*>(
+                    MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("GridFile::GridFile: cannot open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        length = static_cast<std::size_t>(st.st_size);
+        void* address = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (address != MAP_FAILED)
+            data = static_cast<const unsigned char*>(address);
+    }
+    ::close(fd);
+#endif
+
+    const char* error = 0;
+    if (!data) {
+        error = "cannot map ";
+    } else if (length < header_size || std::memcmp(data, magic, sizeof(magic)) != 0 ||
+            data[4] != version) {
+        error = "not a grid file: ";
+    } else {
+        region_num_row = data[5];
+        region_num_col = data[6];
+        solutions = (data[7] & flag_solutions) != 0;
+        unsigned long long count = get_u64(data + 8);
+        unsigned short grid_size = region_num_row * region_num_col;
+        record_size = packed_size(grid_size) * (solutions ? 2 : 1);
+
+        if (region_num_row == 0 || region_num_col == 0 ||
+                region_num_row > 5 || region_num_col > 5) {
+            error = "unsupported geometry in ";
+        } else if (count > (length - header_size) / record_size) {
+            error = "truncated grid file: ";
+        } else {
+            num_records = static_cast<std::size_t>(count);
+        }
+    }
+
+    if (error) {
+        unmap();
+        throw std::runtime_error(std::string("GridFile::GridFile: ") + error + path);
+    }
+}
+
+GridFile::~GridFile() {
+    unmap();
+}
+
+void GridFile::unmap() {
+#if defined(_WIN32)
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+#else
+    if (data)
+        munmap(const_cast<unsigned char*>(data), length);
+#endif
+    data = 0;
+    mapping = 0;
+}
+
+std::size_t GridFile::size() const {
+    return num_records;
+}
+
+unsigned short GridFile::region_num_rows() const {
+    return region_num_row;
+}
+
+unsigned short GridFile::region_num_columns() const {
+    return region_num_col;
+}
+
+bool GridFile::has_solutions() const {
+    return solutions;
+}
+
+GridView GridFile::puzzle(std::size_t i) const {
+    return GridView(data + header_size + i * record_size,
+                    region_num_row * region_num_col);
+}
+
+GridView GridFile::solution(std::size_t i) const {
+    unsigned short grid_size = region_num_row * region_num_col;
+    return GridView(data + header_size + i * record_size + packed_size(grid_size),
+                    grid_size);
+}
+
+unsigned int GridFile::bits_per_cell(unsigned short grid_size) {
+    // The values and the empty code must fit.
+    return grid_size < 16 ? 4 : 5;
+}
+
+std::size_t GridFile::packed_size(unsigned short grid_size) {
+    return (grid_size * grid_size * bits_per_cell(grid_size) + 7) / 8;
+}
+
+void GridFile::pack(const Sudoku& s, unsigned char* out) {
+    unsigned short grid_size = s.size();
+    unsigned int num_cells = grid_size * grid_size;
+    unsigned int bits = bits_per_cell(grid_size);
+    std::memset(out, 0, packed_size(grid_size));
+
+    for (unsigned int i = 0; i < num_cells; ++i) {
+        unsigned char value = s.at(i);
+        unsigned int code = value == Sudoku::empty ? 0 : value + 1u;
+        unsigned int bit = i * bits;
+        out[bit / 8] |= static_cast<unsigned char>(code << (bit % 8));
+        if (bit % 8 + bits > 8)
+            out[bit / 8 + 1] |= static_cast<unsigned char>(code >> (8 - bit % 8));
+    }
+}
+
+GridFileWriter::GridFileWriter(const std::string& path, unsigned short region_num_row,
+        unsigned short region_num_col, bool with_solutions) throw(std::runtime_error):
+        out(path.c_str(), std::ios::binary | std::ios::trunc), path(path),
+        grid_size(region_num_row * region_num_col), with_solutions(with_solutions),
+        num_records(0) {
+
+    if (!out)
+        throw std::runtime_error("GridFileWriter::GridFileWriter: cannot create " + path);
+
+    unsigned char header[GridFile::header_size];
+    std::memcpy(header, magic, sizeof(magic));
+    header[4] = version;
+    header[5] = static_cast<unsigned char>(region_num_row);
+    header[6] = static_cast<unsigned char>(region_num_col);
+    header[7] = with_solutions ? flag_solutions : 0;
+    put_u64(header + 8, 0);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    record.resize(GridFile::packed_size(grid_size) * (with_solutions ? 2 : 1));
+}
+
+GridFileWriter::~GridFileWriter() {
+    try {
+        close();
+    } catch (const std::exception&) {
+    }
+}
+
+void GridFileWriter::write(const Sudoku& puzzle, const Sudoku* solution) {
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(&record[0]);
+    std::size_t size = GridFile::packed_size(grid_size);
+
+    GridFile::pack(puzzle, bytes);
+    if (with_solutions) {
+        if (solution)
+            GridFile::pack(*solution, bytes + size);
+        else
+            std::memset(bytes + size, 0, size);
+    }
+    out.write(record.data(), record.size());
+    num_records++;
+}
+
+void GridFileWriter::close() throw(std::runtime_error) {
+    if (!out.is_open())
+        return;
+
+    unsigned char count[8];
+    put_u64(count, num_records);
+    out.seekp(8);
+    out.write(reinterpret_cast<const char*>(count), sizeof(count));
+    out.close();
+    if (out.fail())
+        throw std::runtime_error("GridFileWriter::close: cannot write " + path);
+}
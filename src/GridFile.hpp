@@ -0,0 +1,181 @@
+//! \file
+//! \brief Binary grid file interface.
+//! \author Mathieu Turcotte
+//!
+//! A grid file starts with a 16 bytes header:
+//!
+//!     offset  size  field
+//!     0       4     magic, "SDKB"
+//!     4       1     format version, 1
+//!     5       1     region vertical size
+//!     6       1     region horizontal size
+//!     7       1     flags, bit 0 set when records hold a solution
+//!     8       8     number of records, little endian
+//!
+//! followed by fixed size records. A record is a packed puzzle, followed by
+//! its packed solution when the file has solutions. A packed grid stores
+//! each cell in row-major order on 4 bits, or 5 bits for grids of more than
+//! 15 values, as 0 for an empty cell and value + 1 otherwise. Cells are
+//! packed from the least significant bit of each byte, and a grid starts
+//! on a byte boundary. An unsolved puzzle has an empty solution.
+
+#ifndef GRID_FILE_H_
+#define GRID_FILE_H_
+
+// Visual C++ does not implement checked exceptions.
+#pragma warning(disable: 4290)
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+
+#include "Sudoku.hpp"
+
+//! \brief Read-only view of a packed grid.
+class GridView {
+public:
+    //! \brief GridView constructor.
+    //! \param bits The packed grid.
+    //! \param grid_size The grid size.
+    GridView(const unsigned char* bits, unsigned short grid_size);
+
+    //! \brief Get the grid size.
+    //! \return The grid size.
+    unsigned short size() const;
+
+    //! \brief Get the value of a cell.
+    //! \param index The cell index (row * size + column).
+    //! \return The cell value, or Sudoku::empty if not set.
+    unsigned char at(unsigned int index) const;
+
+    //! \brief Query whether the grid has no value at all.
+    //! \return True if every cell is empty.
+    bool is_empty() const;
+
+    //! \brief Copy the grid values into a grid.
+    //! \param[out] s A grid of the same size.
+    void copy_to(Sudoku& s) const;
+
+    //! \brief Append the text representation of the grid to a string.
+    //! \param[out] out The string, the grid size squared characters are
+    //!                 appended, 'x' for empty cells.
+    void append_to(std::string& out) const;
+
+protected:
+    const unsigned char* bits;  /**< The packed grid. */
+    unsigned short grid_size;   /**< The grid size. */
+};
+
+//! \brief Memory-mapped reader of a grid file.
+//!
+//! The records are never copied: puzzle and solution return views
+//! into the mapping, valid as long as the file is open.
+class GridFile {
+public:
+    //! \brief Open and map a grid file.
+    //! \param path The file path.
+    //! \throw std::runtime_error If the file can't be mapped or isn't a
+    //!        valid grid file.
+    explicit GridFile(const std::string& path) throw(std::runtime_error);
+
+    //! \brief GridFile destructor, unmaps the file.
+    ~GridFile();
+
+    GridFile(const GridFile&) = delete;
+    GridFile& operator=(const GridFile&) = delete;
+
+    //! \brief Get the number of records.
+    //! \return The number of puzzles in the file.
+    std::size_t size() const;
+
+    //! \brief Get sudoku regions vertical size.
+    //! \return Region vertical size, counted in number of rows.
+    unsigned short region_num_rows() const;
+
+    //! \brief Get sudoku regions horizontal size.
+    //! \return Region horizontal size, counted in number of columns.
+    unsigned short region_num_columns() const;
+
+    //! \brief Query whether the records hold a solution.
+    //! \return True if the file has a solution section.
+    bool has_solutions() const;
+
+    //! \brief Get a puzzle.
+    //! \param i The record index, below size().
+    //! \return A view of the puzzle.
+    GridView puzzle(std::size_t i) const;
+
+    //! \brief Get the solution of a puzzle.
+    //! \param i The record index, below size().
+    //! \return A view of the solution, empty if the puzzle wasn't solved.
+    //! \pre The file has solutions.
+    GridView solution(std::size_t i) const;
+
+    //! \brief Get the number of bits used by a cell.
+    //! \param grid_size The grid size.
+    //! \return 4 or 5.
+    static unsigned int bits_per_cell(unsigned short grid_size);
+
+    //! \brief Get the size of a packed grid.
+    //! \param grid_size The grid size.
+    //! \return The number of bytes of a packed grid.
+    static std::size_t packed_size(unsigned short grid_size);
+
+    //! \brief Pack a grid.
+    //! \param s The grid.
+    //! \param[out] out packed_size(s.size()) bytes.
+    static void pack(const Sudoku& s, unsigned char* out);
+
+    static const std::size_t header_size = 16;  /**< Size of the file header. */
+
+protected:
+    //! \brief Release the mapping, if any.
+    void unmap();
+
+    const unsigned char* data;      /**< The mapped file. */
+    std::size_t length;             /**< The mapped file size. */
+    void* mapping;                  /**< Platform handle of the mapping. */
+    std::size_t num_records;        /**< Number of records. */
+    std::size_t record_size;        /**< Size of a record. */
+    unsigned short region_num_row;  /**< Region vertical size. */
+    unsigned short region_num_col;  /**< Region horizontal size. */
+    bool solutions;                 /**< True if records hold a solution. */
+};
+
+//! \brief Writer of a grid file.
+class GridFileWriter {
+public:
+    //! \brief Create a grid file.
+    //! \param path The file path, overwritten.
+    //! \param region_num_row Number of rows in a region.
+    //! \param region_num_col Number of columns in a region.
+    //! \param with_solutions True to store a solution with each puzzle.
+    //! \throw std::runtime_error If the file can't be created.
+    GridFileWriter(const std::string& path, unsigned short region_num_row,
+                   unsigned short region_num_col, bool with_solutions)
+                   throw(std::runtime_error);
+
+    //! \brief GridFileWriter destructor, closes the file.
+    ~GridFileWriter();
+
+    //! \brief Append a record.
+    //! \param puzzle The puzzle, of the file geometry.
+    //! \param solution Its solution, null if it wasn't solved. Ignored
+    //!                 when the file has no solutions.
+    void write(const Sudoku& puzzle, const Sudoku* solution = 0);
+
+    //! \brief Write the number of records and close the file.
+    //! \throw std::runtime_error If the file couldn't be written.
+    void close() throw(std::runtime_error);
+
+protected:
+    std::ofstream out;                  /**< The file. */
+    std::string path;                   /**< The file path, for errors. */
+    unsigned short grid_size;           /**< The grid size. */
+    bool with_solutions;                /**< True if records hold a solution. */
+    unsigned long long num_records;     /**< Number of records written. */
+    std::string record;                 /**< Record buffer, reused. */
+};
+
+#endif // GRID_FILE_H_
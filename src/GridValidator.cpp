@@ -0,0 +1,195 @@
+//! \file
+//! \brief GridValidator implementation.
+//! \author Mathieu Turcotte
+
+#include <sstream>
+
+#include "GridValidator.hpp"
+
+namespace {
+
+//! \brief Units of a grid geometry.
+//!
+//! Units 0 to size - 1 are the rows, then come the columns and the
+//! regions, numbered left to right and top to bottom.
+class Units {
+public:
+    explicit Units(const Sudoku& s): size(s.size()),
+        rows(s.region_num_rows()), cols(s.region_num_columns()) {
+    }
+
+    //! \brief Get the units of a cell: its row, column and region.
+    void of(unsigned int index, unsigned int unit[3]) const {
+        unsigned int row = index / size;
+        unsigned int col = index % size;
+        unit[0] = row;
+        unit[1] = size + col;
+        unit[2] = 2 * size + row / rows * rows + col / cols;
+    }
+
+    //! \brief Get the i-th cell of a unit.
+    unsigned int cell(unsigned int unit, unsigned int i) const {
+        if (unit < size)
+            return unit * size + i;
+        if (unit < 2 * size)
+            return i * size + unit - size;
+        unsigned int region = unit - 2 * size;
+        return (region / rows * rows + i / cols) * size +
+                region % rows * cols + i % cols;
+    }
+
+    unsigned int size;  /**< Grid size. */
+    unsigned int rows;  /**< Region vertical size. */
+    unsigned int cols;  /**< Region horizontal size. */
+};
+
+//! \brief Compute the masks of every unit of a grid.
+//! \param[out] seen Values held in each unit.
+//! \param[out] repeated Values held more than once in each unit.
+void compute_masks(const Sudoku& s, uint32_t* seen, uint32_t* repeated) {
+    Units units(s);
+    unsigned int num_cells = units.size * units.size;
+    for (unsigned int u = 0; u < 3 * units.size; ++u)
+        seen[u] = repeated[u] = 0;
+
+    for (unsigned int index = 0; index < num_cells; ++index) {
+        unsigned char value = s.at(index);
+        if (value == Sudoku::empty)
+            continue;
+        uint32_t bit = uint32_t(1) << value;
+        unsigned int unit[3];
+        units.of(index, unit);
+        for (unsigned int k = 0; k < 3; ++k) {
+            repeated[unit[k]] |= seen[unit[k]] & bit;
+            seen[unit[k]] |= bit;
+        }
+    }
+}
+
+//! \brief Get the character of a value, as written by Sudoku::write.
+char value_char(unsigned char value) {
+    return value < 10 ? '0' + value : 'A' + value - 10;
+}
+
+} // namespace
+
+GridValidator::GridValidator(const Sudoku& s): s(s) {
+    compute_masks(s, seen, repeated);
+}
+
+void GridValidator::reset(const Sudoku& s) {
+    this->s = s;
+    compute_masks(s, seen, repeated);
+}
+
+bool GridValidator::is_valid(const Sudoku& s, GridConflict* conflict) {
+    Units units(s);
+    unsigned int num_cells = units.size * units.size;
+    uint32_t seen[75] = { 0 };
+
+    for (unsigned int index = 0; index < num_cells; ++index) {
+        unsigned char value = s.at(index);
+        if (value == Sudoku::empty)
+            continue;
+        uint32_t bit = uint32_t(1) << value;
+        unsigned int unit[3];
+        units.of(index, unit);
+        for (unsigned int k = 0; k < 3; ++k) {
+            if ((seen[unit[k]] & bit) == 0) {
+                seen[unit[k]] |= bit;
+                continue;
+            }
+            // Only now look for the cell holding the value first.
+            if (conflict != 0) {
+                for (unsigned int i = 0; i < units.size; ++i) {
+                    unsigned int other = units.cell(unit[k], i);
+                    if (other != index && s.at(other) == value) {
+                        conflict->first = other;
+                        conflict->second = index;
+                        break;
+                    }
+                }
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t GridValidator::find_conflicts(const Sudoku& s, std::vector<unsigned int>& cells) {
+    uint32_t seen[75];
+    uint32_t repeated[75];
+    compute_masks(s, seen, repeated);
+
+    Units units(s);
+    unsigned int num_cells = units.size * units.size;
+    cells.clear();
+    for (unsigned int index = 0; index < num_cells; ++index) {
+        unsigned char value = s.at(index);
+        if (value == Sudoku::empty)
+            continue;
+        uint32_t bit = uint32_t(1) << value;
+        unsigned int unit[3];
+        units.of(index, unit);
+        if ((repeated[unit[0]] | repeated[unit[1]] | repeated[unit[2]]) & bit)
+            cells.push_back(index);
+    }
+    return cells.size();
+}
+
+std::string GridValidator::describe(const Sudoku& s, const GridConflict& conflict) {
+    unsigned int size = s.size();
+    std::ostringstream message;
+    message << "conflicting givens: r" << conflict.first / size + 1
+            << 'c' << conflict.first % size + 1 << " and r"
+            << conflict.second / size + 1 << 'c' << conflict.second % size + 1
+            << " both hold " << value_char(s.at(conflict.first));
+    return message.str();
+}
+
+void GridValidator::set(unsigned short row, unsigned short col, unsigned char value) {
+    unsigned int index = row * s.size() + col;
+    if (s.at(index) == value)
+        return;
+    s.set_at(index, value);
+
+    unsigned int unit[3];
+    Units(s).of(index, unit);
+    for (unsigned int k = 0; k < 3; ++k)
+        update(unit[k]);
+}
+
+bool GridValidator::is_legal(unsigned short row, unsigned short col,
+        unsigned short value) const {
+    unsigned int index = row * s.size() + col;
+    uint32_t bit = uint32_t(1) << value;
+    unsigned int unit[3];
+    Units(s).of(index, unit);
+
+    // The cell itself doesn't count: if it holds the value, another
+    // cell of the unit holds it too only if it is repeated.
+    const uint32_t* masks = s.at(index) == value ? repeated : seen;
+    return ((masks[unit[0]] | masks[unit[1]] | masks[unit[2]]) & bit) == 0;
+}
+
+bool GridValidator::conflicting(unsigned short row, unsigned short col) const {
+    unsigned char value = s.at(row * s.size() + col);
+    return value != Sudoku::empty && !is_legal(row, col, value);
+}
+
+const Sudoku& GridValidator::grid() const {
+    return s;
+}
+
+void GridValidator::update(unsigned int unit) {
+    Units units(s);
+    seen[unit] = repeated[unit] = 0;
+    for (unsigned int i = 0; i < units.size; ++i) {
+        unsigned char value = s.at(units.cell(unit, i));
+        if (value == Sudoku::empty)
+            continue;
+        uint32_t bit = uint32_t(1) << value;
+        repeated[unit] |= seen[unit] & bit;
+        seen[unit] |= bit;
+    }
+}
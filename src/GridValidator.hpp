@@ -0,0 +1,95 @@
+//! \file
+//! \brief GridValidator interface.
+//! \author Mathieu Turcotte
+
+#ifndef GRID_VALIDATOR_H_
+#define GRID_VALIDATOR_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "Sudoku.hpp"
+
+//! \brief Two givens of a row, column or region holding the same value.
+struct GridConflict {
+    unsigned int first;     /**< Index of the first cell (row * size + column). */
+    unsigned int second;    /**< Index of the second cell, after the first. */
+};
+
+//! \brief Check of the givens of a grid against the sudoku rules.
+//!
+//! Each row, column and region has a mask of the values its cells hold,
+//! bit v standing for value v, and a mask of the values held more than
+//! once. A grid is checked in a single pass over its cells, so bad inputs
+//! can be rejected before any solver work.
+//!
+//! A validator also follows a grid as it is edited, one cell at a time:
+//! set updates the masks of the cell row, column and region, and is_legal
+//! and conflicting answer from the masks.
+class GridValidator {
+public:
+    //! \brief GridValidator constructor.
+    //! \param s The grid to follow.
+    explicit GridValidator(const Sudoku& s);
+
+    //! \brief Follow another grid.
+    //! \param s The grid, which may have another geometry.
+    void reset(const Sudoku& s);
+
+    //! \brief Check that no two givens of a grid conflict.
+    //! \param s The grid.
+    //! \param[out] conflict The first conflict found, may be null.
+    //! \return True if the grid has no conflict.
+    static bool is_valid(const Sudoku& s, GridConflict* conflict = 0);
+
+    //! \brief Find the givens of a grid which conflict with another one.
+    //! \param s The grid.
+    //! \param[out] cells The conflicting cells, in increasing index order.
+    //! \return The number of conflicting cells.
+    static std::size_t find_conflicts(const Sudoku& s, std::vector<unsigned int>& cells);
+
+    //! \brief Describe a conflict.
+    //! \param s The grid.
+    //! \param conflict A conflict of the grid.
+    //! \return A message naming the cells, as row and column from 1, and
+    //!         their value, as written by Sudoku::write.
+    static std::string describe(const Sudoku& s, const GridConflict& conflict);
+
+    //! \brief Set a cell of the followed grid.
+    //! \param row The cell row.
+    //! \param col The cell column.
+    //! \param value The cell value, or Sudoku::empty to clear the cell.
+    //! \pre The value is below the grid size, or empty.
+    void set(unsigned short row, unsigned short col, unsigned char value);
+
+    //! \brief Query whether a value can go in a cell.
+    //! \param row The cell row.
+    //! \param col The cell column.
+    //! \param value The value, below the grid size.
+    //! \return True if no other cell of the row, column or region holds
+    //!         the value.
+    bool is_legal(unsigned short row, unsigned short col, unsigned short value) const;
+
+    //! \brief Query whether a cell conflicts with another one.
+    //! \param row The cell row.
+    //! \param col The cell column.
+    //! \return True if the cell is set and another cell of its row,
+    //!         column or region holds the same value.
+    bool conflicting(unsigned short row, unsigned short col) const;
+
+    //! \brief Get the followed grid.
+    const Sudoku& grid() const;
+
+protected:
+    //! \brief Recompute the masks of a unit from the grid.
+    //! \param unit The unit: rows, then columns, then regions.
+    void update(unsigned int unit);
+
+    Sudoku s;                   /**< The followed grid. */
+    uint32_t seen[75];          /**< Values held in each row, column and region. */
+    uint32_t repeated[75];      /**< Values held more than once in each row, column and region. */
+};
+
+#endif // GRID_VALIDATOR_H_
@@ -0,0 +1,203 @@
+//! \file
+//! \brief ParallelDancingLinksSolver implementation.
+//! \author Mathieu Turcotte
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "ParallelSolver.hpp"
+#include "GridValidator.hpp"
+
+namespace {
+
+//! \brief Subtrees wanted per thread, so that a thread done with an
+//!        easy subtree can pick up another one.
+const std::size_t subtrees_per_thread = 8;
+
+//! \brief Deepest level expanded before handing out the subtrees.
+const unsigned int max_expand_depth = 16;
+
+//! \brief Set the values selected along a path.
+void apply_path(Sudoku& s, const std::vector<unsigned int>& path) {
+    unsigned int size = s.size();
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        s.set_at(path[i] / size, path[i] % size);
+    }
+}
+
+} // namespace
+
+ParallelDancingLinksSolver::ParallelDancingLinksSolver(unsigned int num_threads):
+    num_threads(num_threads), generation(0), num_busy(0), quit(false),
+    grid(0), subtrees(0), next_subtree(0), stop(false) {
+
+    if (this->num_threads == 0)
+        this->num_threads = std::thread::hardware_concurrency();
+    if (this->num_threads == 0)
+        this->num_threads = 1;
+
+    for (unsigned int i = 0; i < this->num_threads; ++i)
+        workers.push_back(std::unique_ptr<DancingLinksSolver>(new DancingLinksSolver));
+}
+
+ParallelDancingLinksSolver::~ParallelDancingLinksSolver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    grid_posted.notify_all();
+    for (std::size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+}
+
+bool ParallelDancingLinksSolver::solve(Sudoku& s) {
+    // A single thread has nothing to share.
+    if (num_threads == 1)
+        return DancingLinksSolver::solve(s);
+    if (!GridValidator::is_valid(s))
+        return false;
+    CoverMatrix& cm = cover_matrix(s);
+
+    // Expand one more level at a time until there are enough subtrees.
+    std::vector<std::vector<unsigned int> > subtrees;
+    std::vector<unsigned int> path;
+    bool solved = apply_givens(cm, s);
+
+    for (unsigned int depth = 1; solved && depth <= max_expand_depth; ++depth) {
+        subtrees.clear();
+        path.clear();
+        if (expand(cm, depth, path, subtrees))
+            break;
+        if (subtrees.empty())
+            solved = false;
+        else if (subtrees.size() >= subtrees_per_thread * num_threads)
+            break;
+    }
+    remove_givens(cm);
+
+    if (!solved)
+        return false;
+    if (subtrees.empty()) {
+        // Solved while expanding.
+        apply_path(s, path);
+        return true;
+    }
+
+    // Starting threads costs more than an easy grid takes to solve,
+    // they are kept for the next grids. The calling thread is worker 0.
+    if (threads.empty()) {
+        for (unsigned int i = 1; i < num_threads; ++i)
+            threads.push_back(std::thread(&ParallelDancingLinksSolver::work, this, i));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        grid = &s;
+        this->subtrees = &subtrees;
+        next_subtree.store(0);
+        stop.store(false);
+        result.reset();
+        num_busy = num_threads - 1;
+        generation++;
+    }
+    grid_posted.notify_all();
+    search(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    grid_done.wait(lock, [this]() { return num_busy == 0; });
+    grid = 0;
+    this->subtrees = 0;
+    if (!result)
+        return false;
+    s = *result;
+    return true;
+}
+
+void ParallelDancingLinksSolver::work(unsigned int id) {
+    unsigned long done = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            grid_posted.wait(lock, [&]() { return quit || generation != done; });
+            if (quit)
+                break;
+            done = generation;
+        }
+
+        search(id);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--num_busy == 0)
+            grid_done.notify_one();
+    }
+}
+
+void ParallelDancingLinksSolver::search(unsigned int id) {
+    DancingLinksSolver& worker = *workers[id];
+    worker.set_stop_flag(&stop);
+
+    // Subtrees are picked in order as the workers become free.
+    for (;;) {
+        std::size_t k = next_subtree++;
+        if (k >= subtrees->size() || stop.load())
+            break;
+
+        Sudoku subtree(*grid);
+        apply_path(subtree, (*subtrees)[k]);
+        if (worker.solve(subtree)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!result)
+                result.reset(new Sudoku(subtree));
+            stop.store(true);
+        }
+    }
+    worker.set_stop_flag(0);
+}
+
+bool ParallelDancingLinksSolver::expand(const CoverMatrix& cm,
+        unsigned int depth, std::vector<unsigned int>& path,
+        std::vector<std::vector<unsigned int> >& subtrees) {
+
+    if (depth == 0) {
+        subtrees.push_back(path);
+        return false;
+    }
+
+    Index column_header = choose_next_column();
+    if (column_header == 0)
+        return true;
+
+    const VerticalLinks* vertical = &cm.vertical[0];
+    const HorizontalLinks* horizontal = &cm.horizontal[0];
+    bool solved = false;
+    cover_column(column_header);
+
+    Index column_element = vertical[column_header].down;
+    while (column_element != column_header && !solved) {
+
+        Index row_element = horizontal[column_element].right;
+        while (row_element != column_element) {
+            cover_column(cm.column[row_element]);
+            row_element = horizontal[row_element].right;
+        }
+
+        path.push_back(cm.row_of(column_element));
+        solved = expand(cm, depth - 1, path, subtrees);
+        if (!solved)
+            path.pop_back();
+
+        row_element = horizontal[column_element].left;
+        while (row_element != column_element) {
+            uncover_column(cm.column[row_element]);
+            row_element = horizontal[row_element].left;
+        }
+
+        column_element = vertical[column_element].down;
+    }
+
+    uncover_column(column_header);
+    return solved;
+}
@@ -0,0 +1,82 @@
+//! \file
+//! \brief ParallelDancingLinksSolver interface.
+//! \author Mathieu Turcotte
+
+#ifndef PARALLEL_SOLVER_H_
+#define PARALLEL_SOLVER_H_
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include "SudokuSolver.hpp"
+
+//! \brief Dancing links solver searching a single grid on several threads.
+//!
+//! The first levels of the search tree are expanded until there are
+//! enough subtrees to keep every thread busy. Each subtree is then a grid
+//! with a few more values set, which the workers pick one after the other
+//! and search with their own cover matrix. The first worker to find a
+//! solution stops the others.
+//!
+//! The calling thread searches too. The other worker threads are started
+//! by the first grid which needs them and then wait for the next grids,
+//! until the solver is destroyed.
+class ParallelDancingLinksSolver: public DancingLinksSolver {
+public:
+    //! \brief ParallelDancingLinksSolver constructor.
+    //! \param num_threads Number of threads, 0 for one per core.
+    explicit ParallelDancingLinksSolver(unsigned int num_threads = 0);
+
+    //! \brief ParallelDancingLinksSolver destructor, stops the threads.
+    ~ParallelDancingLinksSolver();
+
+    //! \brief Solve a sudoku grid.
+    //! \param[out] s The sudoku grid to solve.
+    //! \return True if the grid was solved, false otherwise.
+    //!
+    //! The grid won't be modified if no solution are found.
+    bool solve(Sudoku& s);
+
+protected:
+    //! \brief Expand the search tree down to a given depth.
+    //! \param cm The cover matrix, with the grid givens applied.
+    //! \param depth The number of levels left to expand.
+    //! \param[in,out] path The rows selected so far, as cell index * size + value.
+    //! \param[out] subtrees The paths to the subtrees left at the given depth.
+    //! \return True if the path reached a solution, which is left in path.
+    bool expand(const CoverMatrix& cm, unsigned int depth,
+                std::vector<unsigned int>& path,
+                std::vector<std::vector<unsigned int> >& subtrees);
+
+    //! \brief Worker thread loop: search the subtrees of each grid.
+    //! \param id The worker index.
+    void work(unsigned int id);
+
+    //! \brief Search the subtrees of the current grid until none is left
+    //!        or a solution is found.
+    //! \param id The worker index.
+    void search(unsigned int id);
+
+    unsigned int num_threads;   /**< Number of threads searching. */
+    std::vector<std::unique_ptr<DancingLinksSolver> > workers;  /**< Solver of each thread. */
+    std::vector<std::thread> threads;   /**< Workers 1 and up, empty until needed. */
+
+    std::mutex mutex;                       /**< Protects the fields below. */
+    std::condition_variable grid_posted;    /**< Signaled when a grid is posted. */
+    std::condition_variable grid_done;      /**< Signaled when the workers are done. */
+    unsigned long generation;   /**< Number of grids posted so far. */
+    unsigned int num_busy;      /**< Workers still searching the grid. */
+    bool quit;                  /**< True when the threads must exit. */
+
+    const Sudoku* grid;         /**< Grid being searched, with its givens. */
+    const std::vector<std::vector<unsigned int> >* subtrees;   /**< Its subtrees. */
+    std::atomic<std::size_t> next_subtree;  /**< Next subtree to search. */
+    std::atomic<bool> stop;                 /**< Raised once a solution is found. */
+    std::unique_ptr<Sudoku> result;         /**< First solution found, under mutex. */
+};
+
+#endif // PARALLEL_SOLVER_H_
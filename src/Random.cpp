@@ -0,0 +1,61 @@
+//! \file
+//! \brief Reproducible random numbers and grid shuffles.
+//! \author Mathieu Turcotte
+
+#include <algorithm>    // std::swap
+
+#include "Random.hpp"
+
+Random::Random(unsigned long seed, unsigned long long index) {
+    std::seed_seq sequence = {
+        static_cast<unsigned int>(seed & 0xFFFFFFFFUL),
+        static_cast<unsigned int>((static_cast<unsigned long long>(seed) >> 32) & 0xFFFFFFFFUL),
+        static_cast<unsigned int>(index & 0xFFFFFFFFULL),
+        static_cast<unsigned int>((index >> 32) & 0xFFFFFFFFULL)
+    };
+    engine.seed(sequence);
+}
+
+unsigned int Random::below(unsigned int n) {
+    return engine() % n;
+}
+
+void Random::shuffle(std::vector<unsigned int>& permutation, unsigned int n) {
+    permutation.resize(n);
+    for (unsigned int i = 0; i < n; ++i)
+        permutation[i] = i;
+    for (unsigned int i = n; i > 1; --i)
+        std::swap(permutation[i - 1], permutation[below(i)]);
+}
+
+Sudoku shuffle(const Sudoku& s, Random& random) {
+    unsigned int size = s.size();
+    unsigned int rows = s.region_num_rows();
+    unsigned int cols = s.region_num_columns();
+    std::vector<unsigned int> values, bands, stacks, within;
+    std::vector<unsigned int> row_order(size), col_order(size);
+
+    random.shuffle(values, size);
+    random.shuffle(bands, cols);
+    for (unsigned int band = 0; band < cols; ++band) {
+        random.shuffle(within, rows);
+        for (unsigned int i = 0; i < rows; ++i)
+            row_order[band * rows + i] = bands[band] * rows + within[i];
+    }
+    random.shuffle(stacks, rows);
+    for (unsigned int stack = 0; stack < rows; ++stack) {
+        random.shuffle(within, cols);
+        for (unsigned int i = 0; i < cols; ++i)
+            col_order[stack * cols + i] = stacks[stack] * cols + within[i];
+    }
+
+    Sudoku shuffled(rows, cols);
+    for (unsigned int row = 0; row < size; ++row) {
+        for (unsigned int col = 0; col < size; ++col) {
+            unsigned char value = s.at(row_order[row] * size + col_order[col]);
+            shuffled.set_at(row * size + col,
+                            value == Sudoku::empty ? value : values[value]);
+        }
+    }
+    return shuffled;
+}
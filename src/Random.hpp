@@ -0,0 +1,47 @@
+//! \file
+//! \brief Reproducible random numbers and grid shuffles.
+//! \author Mathieu Turcotte
+
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <random>
+#include <vector>
+
+#include "Sudoku.hpp"
+
+//! \brief Random generator giving the same numbers on every platform.
+//!
+//! std::mt19937 and std::seed_seq give the same sequence everywhere,
+//! unlike the standard distributions, so numbers are drawn with a plain
+//! modulo.
+class Random {
+public:
+    //! \brief Random constructor.
+    //! \param seed The seed of the sequence.
+    //! \param index The position of the sequence among those of the seed,
+    //!        so that each puzzle of a set can have its own.
+    explicit Random(unsigned long seed, unsigned long long index = 0);
+
+    //! \brief Draw a number below n.
+    unsigned int below(unsigned int n);
+
+    //! \brief Shuffle a permutation of n elements.
+    //! \param[out] permutation The permutation of 0 to n - 1.
+    //! \param n The number of elements.
+    void shuffle(std::vector<unsigned int>& permutation, unsigned int n);
+
+protected:
+    std::mt19937 engine;    /**< The generator. */
+};
+
+//! \brief Shuffle a grid without changing its number of solutions.
+//! \param s The grid.
+//! \param random The random generator.
+//! \return The shuffled grid.
+//!
+//! Values are relabeled, rows are permuted within their band and bands
+//! between them, and the same for columns.
+Sudoku shuffle(const Sudoku& s, Random& random);
+
+#endif // RANDOM_H_
@@ -0,0 +1,126 @@
+//! \file
+//! \brief Dancing links search statistics policies.
+//! \author Mathieu Turcotte
+//!
+//! BasicDancingLinksSolver reports the events of its search to a stats
+//! policy. NoStats ignores them and compiles away; SearchStats counts
+//! them.
+
+#ifndef SEARCH_STATS_H_
+#define SEARCH_STATS_H_
+
+#include <chrono>
+
+//! \brief Stats policy recording nothing.
+struct NoStats {
+    void reset() {}
+    void enter() {}
+    void leave() {}
+    void backtrack() {}
+    void cover(unsigned int) {}
+    void uncover(unsigned int) {}
+    void start_choose() {}
+    void stop_choose() {}
+    void start_build() {}
+    void stop_build() {}
+};
+
+//! \brief Stats policy counting the search events.
+//!
+//! Counters of several solves, possibly made on different threads, are
+//! summed with operator+=.
+struct SearchStats {
+    unsigned long long nodes;           /**< Search nodes visited. */
+    unsigned long long covers;          /**< cover_column calls. */
+    unsigned long long uncovers;        /**< uncover_column calls. */
+    unsigned long long link_updates;    /**< Links rewritten by cover_column and uncover_column. */
+    unsigned long long backtracks;      /**< Rows undone to try the next one. */
+    unsigned int max_depth;             /**< Deepest search node, counted in rows. */
+    double choose_seconds;              /**< Time spent choosing columns. */
+    double build_seconds;               /**< Time spent building cover matrices. */
+
+    //! \brief SearchStats constructor (all counters 0).
+    SearchStats() {
+        reset();
+    }
+
+    //! \brief Reset every counter.
+    void reset() {
+        nodes = covers = uncovers = link_updates = backtracks = 0;
+        max_depth = depth = 0;
+        choose_seconds = build_seconds = 0;
+    }
+
+    //! \brief Add the counters of another solve.
+    //! \param rhs The counters to add, max_depth is the maximum of both.
+    SearchStats& operator+=(const SearchStats& rhs) {
+        nodes += rhs.nodes;
+        covers += rhs.covers;
+        uncovers += rhs.uncovers;
+        link_updates += rhs.link_updates;
+        backtracks += rhs.backtracks;
+        if (rhs.max_depth > max_depth)
+            max_depth = rhs.max_depth;
+        choose_seconds += rhs.choose_seconds;
+        build_seconds += rhs.build_seconds;
+        return *this;
+    }
+
+    //! \brief A search node is entered.
+    void enter() {
+        nodes++;
+        if (++depth > max_depth)
+            max_depth = depth;
+    }
+
+    //! \brief A search node is left.
+    void leave() {
+        depth--;
+    }
+
+    //! \brief A row is undone to try the next one.
+    void backtrack() {
+        backtracks++;
+    }
+
+    //! \brief A column was covered.
+    //! \param links The number of links rewritten.
+    void cover(unsigned int links) {
+        covers++;
+        link_updates += links;
+    }
+
+    //! \brief A column was uncovered.
+    //! \param links The number of links rewritten.
+    void uncover(unsigned int links) {
+        uncovers++;
+        link_updates += links;
+    }
+
+    void start_choose() {
+        started = std::chrono::steady_clock::now();
+    }
+
+    void stop_choose() {
+        choose_seconds += elapsed();
+    }
+
+    void start_build() {
+        started = std::chrono::steady_clock::now();
+    }
+
+    void stop_build() {
+        build_seconds += elapsed();
+    }
+
+protected:
+    double elapsed() const {
+        return std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - started).count();
+    }
+
+    unsigned int depth;     /**< Depth of the current search node. */
+    std::chrono::steady_clock::time_point started;  /**< Start of the phase being timed. */
+};
+
+#endif // SEARCH_STATS_H_
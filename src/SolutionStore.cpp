@@ -0,0 +1,419 @@
+//! \file
+//! \brief Persistent solution store implementation.
+//! \author Mathieu Turcotte
+
+#include <atomic>
+#include <chrono>
+#include <cstring>  // std::memcmp, std::memcpy, std::memset
+#include <sstream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "SolutionStore.hpp"
+#include "GridFile.hpp"
+
+namespace {
+
+const char magic[4] = { 'S', 'D', 'K', 'D' };
+const unsigned char version = 1;
+const uint32_t byte_order_mark = 0x01020304;
+
+//! \brief Bits of an index slot holding the record number plus one.
+const unsigned int record_bits = 40;
+const uint64_t record_mask = (uint64_t(1) << record_bits) - 1;
+
+//! \brief Offset of the packed puzzle in a record.
+const std::size_t stats_size = 16;
+
+//! \brief Largest packed grid, a 25x25 grid on 5 bits per cell.
+const std::size_t max_grid_bytes = (25 * 25 * 5 + 7) / 8;
+
+// Slots and the record count are shared between processes through the
+// mapping: their atomic operations must not rely on a lock.
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "64 bits atomics must be lock free");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "64 bits atomics must have the size of a 64 bits integer");
+
+inline std::atomic<uint64_t>& atomic_at(uint64_t* word) {
+    return *reinterpret_cast<std::atomic<uint64_t>*>(word);
+}
+
+//! \brief Write a little endian 64 bits integer.
+void put_u64(unsigned char* out, unsigned long long value) {
+    for (unsigned int i = 0; i < 8; ++i)
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+//! \brief Read a little endian 64 bits integer.
+unsigned long long get_u64(const unsigned char* in) {
+    unsigned long long value = 0;
+    for (unsigned int i = 0; i < 8; ++i)
+        value |= static_cast<unsigned long long>(in[i]) << (8 * i);
+    return value;
+}
+
+//! \brief Get the size of a record.
+std::size_t get_record_size(std::size_t grid_bytes) {
+    return (stats_size + 2 * grid_bytes + 7) / 8 * 8;
+}
+
+} // namespace
+
+SolutionStore::SolutionStore(const std::string& path) throw(std::runtime_error):
+    data(0), length(0), mapping(0), slots(0), num_records(0), records(0),
+    num_slots(0), max_records(0), record_size(0), grid_bytes(0),
+    region_num_row(0), region_num_col(0) {
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("SolutionStore::SolutionStore: cannot open " + path);
+
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        length = static_cast<std::size_t>(file_size.QuadPart);
+        mapping = CreateFileMappingA(file, 0, PAGE_READWRITE, 0, 0, 0);
+        if (mapping)
+            data = static_cast<unsigned char*>(
+                    MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0)
+        throw std::runtime_error("SolutionStore::SolutionStore: cannot open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        length = static_cast<std::size_t>(st.st_size);
+        void* address = mmap(0, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address != MAP_FAILED)
+            data = static_cast<unsigned char*>(address);
+    }
+    ::close(fd);
+#endif
+
+    const char* error = 0;
+    uint32_t mark = 0;
+    if (data)
+        std::memcpy(&mark, data + 8, sizeof(mark));
+    if (!data) {
+        error = "cannot map ";
+    } else if (length < header_size || std::memcmp(data, magic, sizeof(magic)) != 0 ||
+            data[4] != version) {
+        error = "not a solution store: ";
+    } else if (mark != byte_order_mark) {
+        error = "solution store of another byte order: ";
+    } else {
+        region_num_row = data[5];
+        region_num_col = data[6];
+        uint64_t count_slots, count_records;
+        std::memcpy(&count_slots, data + 16, sizeof(count_slots));
+        std::memcpy(&count_records, data + 24, sizeof(count_records));
+
+        if (region_num_row == 0 || region_num_col == 0 ||
+                region_num_row > 5 || region_num_col > 5) {
+            error = "unsupported geometry in ";
+        } else {
+            grid_bytes = GridFile::packed_size(region_num_row * region_num_col);
+            record_size = get_record_size(grid_bytes);
+            // Every record must have a slot, and the file must hold them all.
+            if (count_slots == 0 || (count_slots & (count_slots - 1)) != 0 ||
+                    count_records >= count_slots || count_records > record_mask ||
+                    count_slots > (length - header_size) / 8 ||
+                    count_records > (length - header_size - count_slots * 8) / record_size) {
+                error = "truncated or corrupt solution store: ";
+            } else {
+                num_slots = static_cast<std::size_t>(count_slots);
+                max_records = static_cast<std::size_t>(count_records);
+                num_records = reinterpret_cast<uint64_t*>(data + 32);
+                slots = reinterpret_cast<uint64_t*>(data + header_size);
+                records = data + header_size + num_slots * 8;
+            }
+        }
+    }
+
+    if (error) {
+        unmap();
+        throw std::runtime_error(std::string("SolutionStore::SolutionStore: ") + error + path);
+    }
+}
+
+SolutionStore::~SolutionStore() {
+    unmap();
+}
+
+void SolutionStore::unmap() {
+#if defined(_WIN32)
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+#else
+    if (data)
+        munmap(data, length);
+#endif
+    data = 0;
+    mapping = 0;
+}
+
+bool SolutionStore::create(const std::string& path, unsigned short region_num_row,
+        unsigned short region_num_col, std::size_t max_records)
+        throw(std::invalid_argument, std::runtime_error) {
+
+    if (region_num_row == 0 || region_num_col == 0 || region_num_row > 5 ||
+            region_num_col > 5 || max_records == 0 || max_records > record_mask)
+        throw std::invalid_argument("SolutionStore::create: invalid geometry or capacity");
+
+    // At most half of the slots are used, probes stay short.
+    unsigned long long num_slots = 1;
+    while (num_slots < 2ULL * max_records)
+        num_slots *= 2;
+    std::size_t grid_bytes = GridFile::packed_size(region_num_row * region_num_col);
+    unsigned long long file_size = header_size + num_slots * 8 +
+            static_cast<unsigned long long>(max_records) * get_record_size(grid_bytes);
+
+    unsigned char header[header_size];
+    std::memset(header, 0, sizeof(header));
+    std::memcpy(header, magic, sizeof(magic));
+    header[4] = version;
+    header[5] = static_cast<unsigned char>(region_num_row);
+    header[6] = static_cast<unsigned char>(region_num_col);
+    std::memcpy(header + 8, &byte_order_mark, sizeof(byte_order_mark));
+    uint64_t count = num_slots;
+    std::memcpy(header + 16, &count, sizeof(count));
+    count = max_records;
+    std::memcpy(header + 24, &count, sizeof(count));
+
+    std::ostringstream temporary;
+#if defined(_WIN32)
+    temporary << path << ".tmp." << GetCurrentProcessId();
+    std::string tmp = temporary.str();
+    HANDLE file = CreateFileA(tmp.c_str(), GENERIC_WRITE, 0, 0, CREATE_NEW,
+                              FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("SolutionStore::create: cannot create " + tmp);
+
+    DWORD returned;
+    DeviceIoControl(file, FSCTL_SET_SPARSE, 0, 0, 0, 0, &returned, 0);
+    LARGE_INTEGER offset;
+    offset.QuadPart = static_cast<LONGLONG>(file_size);
+    DWORD written = 0;
+    bool ok = SetFilePointerEx(file, offset, 0, FILE_BEGIN) && SetEndOfFile(file);
+    offset.QuadPart = 0;
+    ok = ok && SetFilePointerEx(file, offset, 0, FILE_BEGIN) &&
+            WriteFile(file, header, sizeof(header), &written, 0) && written == sizeof(header);
+    CloseHandle(file);
+
+    if (!ok) {
+        DeleteFileA(tmp.c_str());
+        throw std::runtime_error("SolutionStore::create: cannot write " + tmp);
+    }
+    // Fails if another process created the store meanwhile.
+    if (!MoveFileExA(tmp.c_str(), path.c_str(), 0)) {
+        DWORD error = GetLastError();
+        DeleteFileA(tmp.c_str());
+        if (error == ERROR_ALREADY_EXISTS || error == ERROR_FILE_EXISTS)
+            return false;
+        throw std::runtime_error("SolutionStore::create: cannot create " + path);
+    }
+#else
+    temporary << path << ".tmp." << getpid();
+    std::string tmp = temporary.str();
+    int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+        throw std::runtime_error("SolutionStore::create: cannot create " + tmp);
+
+    // Truncating to the full size leaves a hole where the system can.
+    bool ok = static_cast<off_t>(file_size) > 0 &&
+            static_cast<unsigned long long>(static_cast<off_t>(file_size)) == file_size &&
+            ftruncate(fd, static_cast<off_t>(file_size)) == 0 &&
+            pwrite(fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    ok = ::close(fd) == 0 && ok;
+
+    if (!ok) {
+        unlink(tmp.c_str());
+        throw std::runtime_error("SolutionStore::create: cannot write " + tmp);
+    }
+    // Unlike rename, link fails if another process created the store meanwhile.
+    if (link(tmp.c_str(), path.c_str()) != 0) {
+        int error = errno;
+        unlink(tmp.c_str());
+        if (error == EEXIST)
+            return false;
+        throw std::runtime_error("SolutionStore::create: cannot create " + path);
+    }
+    unlink(tmp.c_str());
+#endif
+    return true;
+}
+
+bool SolutionStore::find(const Sudoku& puzzle, Sudoku* solution, SolveInfo* info) const {
+    if (puzzle.region_num_rows() != region_num_row ||
+            puzzle.region_num_columns() != region_num_col)
+        return false;
+
+    unsigned char packed[max_grid_bytes];
+    GridFile::pack(puzzle, packed);
+    const unsigned char* record = lookup(packed, hash(packed));
+    if (!record)
+        return false;
+
+    GridView solved(record + stats_size + grid_bytes, puzzle.size());
+    if (info) {
+        info->solved = !solved.is_empty();
+        info->nanoseconds = get_u64(record);
+        info->nodes = get_u64(record + 8);
+    }
+    if (solution && !solved.is_empty())
+        solved.copy_to(*solution);
+    return true;
+}
+
+SolutionStore::InsertStatus SolutionStore::insert(const Sudoku& puzzle,
+        const Sudoku* solution, const SolveInfo& info) {
+    if (puzzle.region_num_rows() != region_num_row ||
+            puzzle.region_num_columns() != region_num_col)
+        return insert_mismatch;
+
+    unsigned char packed[max_grid_bytes];
+    GridFile::pack(puzzle, packed);
+    uint64_t h = hash(packed);
+    if (lookup(packed, h))
+        return insert_present;
+
+    uint64_t n = atomic_at(num_records).fetch_add(1, std::memory_order_relaxed);
+    if (n >= max_records)
+        return insert_full;
+
+    // Nobody reads the record before it is published.
+    unsigned char* record = records + n * record_size;
+    put_u64(record, info.nanoseconds);
+    put_u64(record + 8, info.nodes);
+    std::memcpy(record + stats_size, packed, grid_bytes);
+    if (solution && info.solved)
+        GridFile::pack(*solution, record + stats_size + grid_bytes);
+    else
+        std::memset(record + stats_size + grid_bytes, 0, grid_bytes);
+
+    uint64_t value = (h & ~record_mask) | (n + 1);
+    std::size_t mask = num_slots - 1;
+    for (std::size_t i = h & mask, probes = 0; probes < num_slots; i = (i + 1) & mask, ++probes) {
+        std::atomic<uint64_t>& slot = atomic_at(slots + i);
+        uint64_t current = slot.load(std::memory_order_acquire);
+        if (current == 0) {
+            // Release: the record is written before the slot points to it.
+            if (slot.compare_exchange_strong(current, value, std::memory_order_release,
+                                             std::memory_order_acquire))
+                return insert_added;
+        }
+        // Another writer may have just published the same puzzle.
+        if ((current & ~record_mask) == (h & ~record_mask)) {
+            const unsigned char* other = records + ((current & record_mask) - 1) * record_size;
+            if (std::memcmp(other + stats_size, packed, grid_bytes) == 0)
+                return insert_present;
+        }
+    }
+    return insert_full;
+}
+
+std::size_t SolutionStore::size() const {
+    uint64_t n = atomic_at(num_records).load(std::memory_order_relaxed);
+    return n < max_records ? static_cast<std::size_t>(n) : max_records;
+}
+
+std::size_t SolutionStore::capacity() const {
+    return max_records;
+}
+
+unsigned short SolutionStore::region_num_rows() const {
+    return region_num_row;
+}
+
+unsigned short SolutionStore::region_num_columns() const {
+    return region_num_col;
+}
+
+uint64_t SolutionStore::hash(const unsigned char* packed) const {
+    // FNV-1a, then a finalizer so that the low bits, which pick the
+    // slot, depend on every cell.
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < grid_bytes; ++i)
+        h = (h ^ packed[i]) * 0x100000001b3ULL;
+    h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdULL;
+    h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+const unsigned char* SolutionStore::lookup(const unsigned char* packed, uint64_t hash) const {
+    std::size_t mask = num_slots - 1;
+    for (std::size_t i = hash & mask, probes = 0; probes < num_slots; i = (i + 1) & mask, ++probes) {
+        // Acquire: a published slot comes with its record.
+        uint64_t current = atomic_at(slots + i).load(std::memory_order_acquire);
+        if (current == 0)
+            return 0;
+        if ((current & ~record_mask) != (hash & ~record_mask))
+            continue;
+        const unsigned char* record = records + ((current & record_mask) - 1) * record_size;
+        if (std::memcmp(record + stats_size, packed, grid_bytes) == 0)
+            return record;
+    }
+    return 0;
+}
+
+StoreSolver::StoreSolver(SolutionStore& store, SudokuSolver* solver):
+    store(store), solver(solver), found(0), added(0), skipped(0) {
+}
+
+bool StoreSolver::solve(Sudoku& s) {
+    if (s.region_num_rows() != store.region_num_rows() ||
+            s.region_num_columns() != store.region_num_columns()) {
+        skipped++;
+        return solver->solve(s);
+    }
+
+    SolveInfo info;
+    if (store.find(s, &s, &info)) {
+        found++;
+        return info.solved;
+    }
+
+    puzzle = s;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    info.solved = solver->solve(s);
+    info.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    StatsDancingLinksSolver* instrumented = dynamic_cast<StatsDancingLinksSolver*>(solver.get());
+    info.nodes = instrumented ? instrumented->search_stats().nodes : 0;
+
+    if (store.insert(puzzle, info.solved ? &s : 0, info) == SolutionStore::insert_added)
+        added++;
+    return info.solved;
+}
+
+SudokuSolver& StoreSolver::inner() {
+    return *solver;
+}
+
+unsigned long long StoreSolver::num_found() const {
+    return found;
+}
+
+unsigned long long StoreSolver::num_added() const {
+    return added;
+}
+
+unsigned long long StoreSolver::num_skipped() const {
+    return skipped;
+}
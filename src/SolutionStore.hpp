@@ -0,0 +1,209 @@
+//! \file
+//! \brief Persistent solution store interface.
+//! \author Mathieu Turcotte
+//!
+//! A solution store is a single file, mapped in memory by every process
+//! using it. It starts with a 64 bytes header:
+//!
+//!     offset  size  field
+//!     0       4     magic, "SDKD"
+//!     4       1     format version, 1
+//!     5       1     region vertical size
+//!     6       1     region horizontal size
+//!     7       1     reserved, 0
+//!     8       4     byte order mark, 0x01020304 in native byte order
+//!     12      4     reserved, 0
+//!     16      8     number of index slots, a power of two
+//!     24      8     maximum number of records
+//!     32      8     number of records reserved so far
+//!     40      24    reserved, 0
+//!
+//! followed by the index, then by the records. Each index slot is 8 bytes:
+//! 0 when free, otherwise the top 24 bits of the puzzle hash and, in the
+//! low 40 bits, the record number plus one. Slots are found by linear
+//! probing from the low bits of the hash. A record is the solve time in
+//! nanoseconds and the number of search nodes, both 8 bytes little
+//! endian, followed by the packed puzzle and the packed solution (see
+//! GridFile), an unsolvable puzzle having an empty solution, padded to a
+//! multiple of 8 bytes.
+//!
+//! The index slots and the record count are updated with atomic
+//! operations in native byte order, so a store can only be shared by
+//! processes of the same architecture. The file is created at its full
+//! size, as a sparse file where the system supports it: disk space is
+//! only used by the records written.
+
+#ifndef SOLUTION_STORE_H_
+#define SOLUTION_STORE_H_
+
+// Visual C++ does not implement checked exceptions.
+#pragma warning(disable: 4290)
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "Sudoku.hpp"
+#include "SudokuSolver.hpp"
+
+//! \brief Statistics of a solve kept with its solution.
+struct SolveInfo {
+    bool solved;                    /**< True if the puzzle has a solution. */
+    unsigned long long nanoseconds; /**< Time the solve took. */
+    unsigned long long nodes;       /**< Search nodes visited, 0 if not counted. */
+};
+
+//! \brief Memory-mapped, append-only store of solved puzzles.
+//!
+//! Records are never modified once written. A writer reserves a record
+//! by incrementing the record count, writes it, then publishes it in the
+//! index with a compare and swap on a free slot. Readers never lock and
+//! never wait: a record is visible once its slot is. Any number of threads
+//! and processes can read and write the same store at once. Two writers
+//! adding the same puzzle at once may both write a record, only one of
+//! them gets in the index.
+//!
+//! The capacity is chosen at creation. Opening a store only maps it, its
+//! index is used as is whatever its size.
+class SolutionStore {
+public:
+    //! \brief Outcome of an insertion.
+    enum InsertStatus {
+        insert_added,       /**< The record was added. */
+        insert_present,     /**< The puzzle was already in the store. */
+        insert_full,        /**< The store has no room left. */
+        insert_mismatch     /**< The puzzle geometry isn't the store one. */
+    };
+
+    //! \brief Open and map a solution store for reading and writing.
+    //! \param path The file path.
+    //! \throw std::runtime_error If the file can't be mapped or isn't a
+    //!        valid solution store.
+    explicit SolutionStore(const std::string& path) throw(std::runtime_error);
+
+    //! \brief SolutionStore destructor, unmaps the file.
+    ~SolutionStore();
+
+    SolutionStore(const SolutionStore&) = delete;
+    SolutionStore& operator=(const SolutionStore&) = delete;
+
+    //! \brief Create an empty solution store.
+    //! \param path The file path.
+    //! \param region_num_row Number of rows in a region.
+    //! \param region_num_col Number of columns in a region.
+    //! \param max_records The maximum number of records.
+    //! \return False if the file already exists, it is left as is.
+    //! \throw std::invalid_argument If the geometry or the capacity isn't
+    //!        supported.
+    //! \throw std::runtime_error If the file can't be created.
+    //!
+    //! The file is written under a temporary name and appears complete,
+    //! so that a process opening it while another one creates it never
+    //! sees half a header.
+    static bool create(const std::string& path, unsigned short region_num_row,
+                       unsigned short region_num_col, std::size_t max_records)
+                       throw(std::invalid_argument, std::runtime_error);
+
+    //! \brief Look a puzzle up.
+    //! \param puzzle The puzzle.
+    //! \param[out] solution Receives the solution if the puzzle is found
+    //!             and solvable, may be null or the puzzle itself.
+    //! \param[out] info Receives the solve statistics if the puzzle is
+    //!             found, may be null.
+    //! \return True if the puzzle is in the store.
+    bool find(const Sudoku& puzzle, Sudoku* solution, SolveInfo* info) const;
+
+    //! \brief Add a solved puzzle.
+    //! \param puzzle The puzzle.
+    //! \param solution Its solution, null if it has none.
+    //! \param info The solve statistics.
+    //! \return The outcome.
+    InsertStatus insert(const Sudoku& puzzle, const Sudoku* solution, const SolveInfo& info);
+
+    //! \brief Get the number of records written.
+    //! \return The number of records, including those of puzzles added
+    //!         by two writers at once.
+    std::size_t size() const;
+
+    //! \brief Get the maximum number of records.
+    std::size_t capacity() const;
+
+    //! \brief Get sudoku regions vertical size.
+    unsigned short region_num_rows() const;
+
+    //! \brief Get sudoku regions horizontal size.
+    unsigned short region_num_columns() const;
+
+    static const std::size_t header_size = 64;  /**< Size of the file header. */
+
+protected:
+    //! \brief Hash a packed puzzle.
+    uint64_t hash(const unsigned char* packed) const;
+
+    //! \brief Find the slot of a packed puzzle.
+    //! \return The record, null if the puzzle isn't indexed.
+    const unsigned char* lookup(const unsigned char* packed, uint64_t hash) const;
+
+    //! \brief Release the mapping, if any.
+    void unmap();
+
+    unsigned char* data;            /**< The mapped file. */
+    std::size_t length;             /**< The mapped file size. */
+    void* mapping;                  /**< Platform handle of the mapping. */
+    uint64_t* slots;                /**< The index. */
+    uint64_t* num_records;          /**< Number of records reserved, in the header. */
+    unsigned char* records;         /**< The records. */
+    std::size_t num_slots;          /**< Number of index slots. */
+    std::size_t max_records;        /**< Maximum number of records. */
+    std::size_t record_size;        /**< Size of a record. */
+    std::size_t grid_bytes;         /**< Size of a packed grid. */
+    unsigned short region_num_row;  /**< Region vertical size. */
+    unsigned short region_num_col;  /**< Region horizontal size. */
+};
+
+//! \brief Solver looking grids up in a solution store before solving them.
+//!
+//! Grids found in the store are answered from it, the others are solved
+//! and added with the solve time and, for a StatsDancingLinksSolver, the
+//! number of search nodes. Grids of another geometry than the store are
+//! only solved, and counted (see num_skipped).
+class StoreSolver: public SudokuSolver {
+public:
+    //! \brief StoreSolver constructor.
+    //! \param store The store, which must outlive the solver.
+    //! \param solver The solver of the grids not in the store, which the
+    //!        store solver then owns.
+    StoreSolver(SolutionStore& store, SudokuSolver* solver);
+
+    StoreSolver(const StoreSolver&) = delete;
+    StoreSolver& operator=(const StoreSolver&) = delete;
+
+    //! \brief Solve a sudoku grid, from the store if possible.
+    //! \param[out] s The sudoku grid to solve.
+    //! \return True if the grid was solved, false otherwise.
+    bool solve(Sudoku& s);
+
+    //! \brief Get the solver of the grids not in the store.
+    SudokuSolver& inner();
+
+    //! \brief Get the number of grids found in the store.
+    unsigned long long num_found() const;
+
+    //! \brief Get the number of grids added to the store.
+    unsigned long long num_added() const;
+
+    //! \brief Get the number of grids of another geometry than the store.
+    unsigned long long num_skipped() const;
+
+protected:
+    SolutionStore& store;                   /**< The store. */
+    std::unique_ptr<SudokuSolver> solver;   /**< Solver of the grids not in the store. */
+    Sudoku puzzle;                          /**< Copy of the grid being solved. */
+    unsigned long long found;               /**< Grids found in the store. */
+    unsigned long long added;               /**< Grids added to the store. */
+    unsigned long long skipped;             /**< Grids of another geometry. */
+};
+
+#endif // SOLUTION_STORE_H_
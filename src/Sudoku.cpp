@@ -5,61 +5,121 @@
 #include <vector>
 #include <string>
 #include <stdexcept>
-#include <algorithm>    // std::transform
-#include <cctype>       // tolower
-#include<sstream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "Sudoku.hpp"
 
-Sudoku::Cell::Cell(unsigned short domain): domain(domain), value(0),
-    cell_is_set(false) {
+const unsigned char Sudoku::empty;
+
+namespace {
+
+//! \brief Marker of a character which is neither a value nor a blank.
+const unsigned char invalid = 0xFE;
+
+//! \brief Packed value of every character of a representation.
+struct CharValues {
+    unsigned char values[256];  /**< Value, empty for blanks, invalid otherwise. */
+
+    CharValues() {
+        for (unsigned int c = 0; c < 256; ++c)
+            values[c] = invalid;
+        for (unsigned int value = 0; value < 10; ++value)
+            values['0' + value] = value;
+        for (unsigned int value = 10; value < 33; ++value) {
+            values['a' + value - 10] = value;
+            values['A' + value - 10] = value;
+        }
+        values['x'] = values['X'] = values[' '] = values['.'] = Sudoku::empty;
+    }
+};
+
+const CharValues char_values;
+
+#if defined(__SSE2__)
+//! \brief Convert 16 characters of a 9x9 representation.
+//! \param repr The characters.
+//! \param[out] out The packed values.
+//! \return False if a character is neither a blank nor a value below 9.
+inline bool parse_block_9x9(const char* repr, unsigned char* out) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(repr));
+
+    // Values: the digits 0 to 8, which are at most 8 once '0' is removed.
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(8)), digit);
+
+    // Blanks: 'x' in either case, space and dot.
+    __m128i blank = _mm_or_si128(
+            _mm_cmpeq_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('x')),
+            _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+                         _mm_cmpeq_epi8(c, _mm_set1_epi8('.'))));
+
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, blank)) != 0xFFFF)
+        return false;
+
+    // Blank lanes are all ones, which is the empty marker.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                     _mm_or_si128(_mm_and_si128(digit, is_digit), blank));
+    return true;
 }
+#endif
 
-Sudoku::Cell::Cell(unsigned short domain, unsigned short value) throw (std::domain_error):
-    domain(domain), value(value), cell_is_set(true) {
+} // namespace
 
-    if (value >= domain)
-        throw std::domain_error("Cell::Cell(unsigned short, unsigned short)");
+Sudoku::ConstCell::ConstCell(const unsigned char* state, unsigned short domain):
+    state(state), domain(domain) {
+}
+
+unsigned short Sudoku::ConstCell::get_value() const throw(std::logic_error) {
+    if (*state == empty)
+        throw std::logic_error("Sudoku::ConstCell::get_value(void)");
+
+    return *state;
+}
+
+bool Sudoku::ConstCell::is_set() const {
+    return *state != empty;
 }
 
-unsigned short Sudoku::Cell::get_value() const throw(std::logic_error) {
-    if (!cell_is_set)
-        throw std::logic_error("Sudoku::Cell::get_value(void)");
+bool Sudoku::ConstCell::operator==(const ConstCell& rhs) const {
+    return domain == rhs.domain && *state == *rhs.state;
+}
+
+bool Sudoku::ConstCell::operator!=(const ConstCell& rhs) const {
+    return !operator==(rhs);
+}
 
-    return value;
+Sudoku::Cell::Cell(unsigned char* state, unsigned short domain):
+    ConstCell(state, domain) {
 }
 
 void Sudoku::Cell::set_value(unsigned short value) throw (std::domain_error) {
     if (value >= domain)
         throw std::domain_error("Cell::set_value(unsigned short)");
 
-    cell_is_set = true;
-    this->value = value;
-}
-
-bool Sudoku::Cell::is_set() const {
-    return cell_is_set;
+    // The state was given non-const to the constructor.
+    *const_cast<unsigned char*>(state) = static_cast<unsigned char>(value);
 }
 
 void Sudoku::Cell::reset() {
-    cell_is_set = false;
+    *const_cast<unsigned char*>(state) = empty;
 }
 
-bool Sudoku::Cell::operator==(const Cell& rhs) {
-    if (cell_is_set) {
-        return domain == rhs.domain &&
-                value == rhs.value &&
-                cell_is_set == rhs.cell_is_set;
-    } else {
-        return domain == rhs.domain &&
-                cell_is_set == rhs.cell_is_set;
-    }
-}
+Sudoku::Sudoku(unsigned short region_num_row, unsigned short region_num_col)
+        throw (std::logic_error):
+        region_num_row(region_num_row), region_num_col(region_num_col) {
 
-bool Sudoku::Cell::operator!=(const Cell& rhs) {
-    return !operator==(rhs);
+    if (region_num_col > 5 || region_num_row > 5)
+        throw std::logic_error("Sudoku::Sudoku(unsigned short, unsigned short): "
+                               "maximum grid size is 25x25.");
+
+    grid_size = region_num_col * region_num_row;
+    cells.assign(grid_size * grid_size, empty);
 }
 
-Sudoku::Sudoku(std::string repr, unsigned short region_num_row,
+Sudoku::Sudoku(const std::string& repr, unsigned short region_num_row,
         unsigned short region_num_col) throw (std::logic_error):
         region_num_row(region_num_row), region_num_col(region_num_col) {
 
@@ -68,70 +128,82 @@ Sudoku::Sudoku(std::string repr, unsigned short region_num_row,
                                "unsigned short, unsigned short): "
                                "maximum grid size is 25x25.");
 
-    // First, obtain the grid size from the region size.
     grid_size = region_num_col * region_num_row;
+    cells.assign(grid_size * grid_size, empty);
 
-    // Then, obtain the number of cells in the grid.
-    unsigned int num_cells = grid_size * grid_size;
-
-    // Make sure that the representation size match
-    // the number of cells in the grid.
-    if (repr.size() != num_cells)
+    switch (parse(repr.data(), repr.size())) {
+    case parse_ok:
+        break;
+    case parse_size_mismatch:
         throw std::logic_error("Sudoku::Sudoku(std::string, "
                                "unsigned short, unsigned short): "
                                "representation size doesn't match "
                                "specified grid size.");
+    case parse_invalid_character:
+        throw std::logic_error("Sudoku::Sudoku(std::string, "
+                               "unsigned short, unsigned short): "
+                               "value out of range in representation");
+    case parse_value_out_of_range:
+        throw std::domain_error("Cell::set_value(unsigned short)");
+    }
+}
 
-    // Build an empty grid.
-    cells.resize(grid_size);
-    for (std::vector<std::vector<Cell> >::iterator it = cells.begin();
-            it != cells.end(); ++it) {
-        it->resize(grid_size, Cell(grid_size));
+Sudoku::ParseStatus Sudoku::parse(const char* repr, std::size_t length) {
+    std::size_t num_cells = cells.size();
+    if (length != num_cells) {
+        cells.assign(num_cells, empty);
+        return parse_size_mismatch;
     }
 
-    // Convert the representation to lowercase.
-    std::transform(repr.begin(), repr.end(), repr.begin(), tolower);
-
-    // Populate the grid with predefined values.
-    for (unsigned short i = 0; i < num_cells; ++i) {
-        if (repr[i] != 'x' && repr[i] != ' ') {
-            unsigned short row = i / grid_size;     // Current row index.
-            unsigned short column = i % grid_size;  // Current column index.
-            unsigned short value;   // A temporary to store the value.
-
-            // Convert the character to a short.
-            if ('a' <= repr[i] && repr[i] <= 'w') {
-                value = static_cast<unsigned short>(repr[i] - 87);
-            } else if ('0' <= repr[i] && repr[i] <= '9') {
-                value = static_cast<unsigned short>(repr[i] - 48);
-            } else {
-                throw std::logic_error("Sudoku::Sudoku(std::string, "
-                                        "unsigned short, unsigned short): "
-                                        "value out of range in representation");
-            }
+#if defined(__SSE2__)
+    // Fast path for the common 9x9 grid, falling back to the
+    // generic loop to report the exact error.
+    if (grid_size == 9) {
+        unsigned char* out = &cells[0];
+        if (parse_block_9x9(repr, out) && parse_block_9x9(repr + 16, out + 16) &&
+                parse_block_9x9(repr + 32, out + 32) && parse_block_9x9(repr + 48, out + 48) &&
+                parse_block_9x9(repr + 64, out + 64) && parse_block_9x9(repr + 65, out + 65))
+            return parse_ok;
+    }
+#endif
 
-            // Then, update the cell representation.
-            cells[row][column] = Cell(grid_size, value);
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        unsigned char value = char_values.values[static_cast<unsigned char>(repr[i])];
+        if (value == invalid || (value != empty && value >= grid_size)) {
+            cells.assign(num_cells, empty);
+            return value == invalid ? parse_invalid_character : parse_value_out_of_range;
         }
+        cells[i] = value;
+    }
+    return parse_ok;
+}
+
+const char* Sudoku::describe(ParseStatus status) {
+    switch (status) {
+    case parse_ok: return "no error";
+    case parse_size_mismatch: return "representation size doesn't match grid size";
+    case parse_invalid_character: return "invalid character in representation";
+    case parse_value_out_of_range: return "value out of range for grid size";
     }
+    return "unknown error";
 }
 
-Sudoku::Cell& Sudoku::cell(unsigned short row, unsigned short col)
+Sudoku::Cell Sudoku::cell(unsigned short row, unsigned short col)
     throw(std::out_of_range) {
 
     if (row >= grid_size || col >= grid_size)
-        throw std::out_of_range("Sudoku::Cell& cell(unsigned short, unsigned short)");
+        throw std::out_of_range("Sudoku::Cell cell(unsigned short, unsigned short)");
 
-    return cells[row][col];
+    return Cell(&cells[row * grid_size + col], grid_size);
 }
 
-const Sudoku::Cell& Sudoku::cell(unsigned short row, unsigned short col) const
+Sudoku::ConstCell Sudoku::cell(unsigned short row, unsigned short col) const
     throw(std::out_of_range) {
 
     if (row >= grid_size || col >= grid_size)
-        throw std::out_of_range("const Sudoku::Cell& cell(unsigned short, unsigned short)");
+        throw std::out_of_range("Sudoku::ConstCell cell(unsigned short, unsigned short)");
 
-    return cells[row][col];
+    return ConstCell(&cells[row * grid_size + col], grid_size);
 }
 
 unsigned short Sudoku::size() const {
@@ -157,21 +229,14 @@ bool Sudoku::operator==(const Sudoku& rhs) {
         return false;
     }
 
-    for (unsigned short i = 0; i < grid_size; ++i) {
-        for (unsigned short j = 0; j < grid_size; ++j) {
-            if (cells[i][j] != rhs.cells[i][j]) {
-                return false;
-            }
-        }
-    }
-    return true;
+    return cells == rhs.cells;
 }
 
 bool Sudoku::operator!=(const Sudoku& rhs) {
     return !operator==(rhs);
 }
 
-std::ostream& operator<<(std::ostream& os, const Sudoku::Cell& cell) {
+std::ostream& operator<<(std::ostream& os, const Sudoku::ConstCell& cell) {
 
     if (cell.is_set()) {
         unsigned int value = cell.get_value();
@@ -221,15 +286,27 @@ std::ostream& operator<<(std::ostream& os, const Sudoku& sudoku) {
     return os;
 }
 
-std::string Sudoku::getString()
-{
-    std::stringstream os;
-     unsigned int region_num_row = this->region_num_rows();
-     unsigned int region_num_col = this->region_num_columns();
-     for (unsigned int i = 0; i < this->size(); ++i) {
-         for (unsigned int j = 0; j < this->size(); ++j) {
-             os << this->cell(i, j);
-         }
-     }
-     return os.str();
+std::size_t Sudoku::write(char* out) const {
+    static const char symbols[] = "0123456789ABCDEFGHIJKLMNO";
+
+    std::size_t num_cells = cells.size();
+    for (std::size_t i = 0; i < num_cells; ++i)
+        out[i] = cells[i] == empty ? 'x' : symbols[cells[i]];
+    return num_cells;
+}
+
+std::size_t Sudoku::write(const Sudoku* first, std::size_t n, char* out,
+        char separator) {
+    char* begin = out;
+    for (std::size_t i = 0; i < n; ++i) {
+        out += first[i].write(out);
+        *out++ = separator;
+    }
+    return out - begin;
+}
+
+std::string Sudoku::getString() const {
+    std::string repr(cells.size(), 'x');
+    write(&repr[0]);
+    return repr;
 }
@@ -9,6 +9,7 @@
 #pragma warning(disable: 4290)
 
 #include <vector>
+#include <cstddef>
 #include <string>
 #include <stdexcept>
 #include <ostream>
@@ -16,68 +17,130 @@
 //! Class representing a sudoku grid.
 class Sudoku {
 public:
-    //! Class representing a grid cell.
-    class Cell {
+    //! \brief Marker of an empty cell in the packed storage.
+    static const unsigned char empty = 0xFF;
+
+    //! \brief Read-only handle on a grid cell.
+    //!
+    //! The grid stores one byte per cell and keeps the domain once; a
+    //! handle refers to that byte. Handles are small values returned by
+    //! Sudoku::cell, they don't outlive the grid storage.
+    class ConstCell {
     public:
-        //! \brief Cell constructor (unset cell).
+        //! \brief ConstCell constructor.
+        //! \param state The packed cell value, empty if not set.
         //! \param domain The cell domain.
-        Cell(unsigned short domain);
-
-        //! \brief Cell constructor (set cell).
-        //! \param domain The cell domain.
-        //! \param value The cell value.
-        Cell(unsigned short domain, unsigned short value) throw (std::domain_error);
+        ConstCell(const unsigned char* state, unsigned short domain);
 
         //! \brief Retrieve the cell value.
         //! \pre The cell value must be set.
         //! \return The cell value.
         unsigned short get_value() const throw(std::logic_error);
 
-        //! \brief Set the cell value.
-        //! \param value The new cell value.
-        void set_value(unsigned short value) throw (std::domain_error);
-
         //! \brief Query the cell status.
         //! \return True if the cell value is set.
         bool is_set() const;
 
-        //! \brief Reset the cell.
-        void reset();
-
         //! \brief Comparaison operator
         //! \param rhs RHS cell.
         //! \return True if cells are equals.
-        bool operator==(const Cell& rhs);
+        bool operator==(const ConstCell& rhs) const;
 
         //! \brief Comparaison operator
         //! \param rhs RHS cell.
         //! \return True if cells are different.
-        bool operator!=(const Cell& rhs);
+        bool operator!=(const ConstCell& rhs) const;
 
     protected:
-        unsigned short domain;  /**< Domain of authorized values. */
-        unsigned short value;   /**< Current cell value. */
-        bool cell_is_set;       /**< Boolean to mark if the cell is set. */
+        const unsigned char* state; /**< Packed cell value in the grid. */
+        unsigned short domain;      /**< Domain of authorized values. */
     };
 
+    //! \brief Handle on a grid cell, checking values against the grid domain.
+    class Cell: public ConstCell {
+    public:
+        //! \brief Cell constructor.
+        //! \param state The packed cell value, empty if not set.
+        //! \param domain The cell domain.
+        Cell(unsigned char* state, unsigned short domain);
+
+        //! \brief Set the cell value.
+        //! \param value The new cell value.
+        void set_value(unsigned short value) throw (std::domain_error);
+
+        //! \brief Reset the cell.
+        void reset();
+    };
+
+    //! \brief Outcome of parsing a representation.
+    enum ParseStatus {
+        parse_ok,                   /**< The grid holds the parsed values. */
+        parse_size_mismatch,        /**< The length isn't the number of cells. */
+        parse_invalid_character,    /**< A character is neither a value nor a blank. */
+        parse_value_out_of_range    /**< A value is not below the grid size. */
+    };
+
+    //! \brief Sudoku constructor (empty grid).
+    //! \param region_num_row Number of rows in a region.
+    //! \param region_num_col Number of columns in a region.
+    explicit Sudoku(unsigned short region_num_row = 3, unsigned short region_num_col = 3)
+            throw (std::logic_error);
+
     //! \brief Sudoku constructor.
-    //! \param repr A string representation of the grid.
+    //! \param repr A string representation of the grid, see parse.
     //! \param region_num_row Number of rows in a region.
     //! \param region_num_col Number of columns in a region.
-    Sudoku(std::string repr, unsigned short region_num_row = 3,
+    Sudoku(const std::string& repr, unsigned short region_num_row = 3,
             unsigned short region_num_col = 3) throw (std::logic_error);
 
-    //! \brief Get a reference to a given cell.
+    //! \brief Replace the grid values by those of a representation.
+    //! \param repr The representation, one character per cell in
+    //!             row-major order: '0' to '9' then 'a' to 'w' (in either
+    //!             case) for the values, 'x', 'X', '.' or space for blanks.
+    //! \param length The representation length.
+    //! \return parse_ok on success. On failure the grid is left empty.
+    //!
+    //! The representation is read in place and the grid keeps its
+    //! storage, so parsing neither copies nor allocates.
+    ParseStatus parse(const char* repr, std::size_t length);
+
+    //! \brief Describe a parse status.
+    //! \param status A parse status.
+    //! \return A static message.
+    static const char* describe(ParseStatus status);
+
+    //! \brief Get a handle on a given cell.
     //! \param row The cell row.
     //! \param col The cell column.
-    //! \return A reference to the specified cell.
-    Cell& cell(unsigned short row, unsigned short col) throw(std::out_of_range);
+    //! \return A handle on the specified cell, by value: cells are stored
+    //!         packed.
+    Cell cell(unsigned short row, unsigned short col) throw(std::out_of_range);
 
-    //! \brief Get a reference to a given cell.
+    //! \brief Get a read-only handle on a given cell.
     //! \param row The cell row.
     //! \param col The cell column.
-    //! \return A const reference to the specified cell.
-    const Cell& cell(unsigned short row, unsigned short col) const throw(std::out_of_range);
+    //! \return A read-only handle on the specified cell.
+    ConstCell cell(unsigned short row, unsigned short col) const throw(std::out_of_range);
+
+    //! \brief Get the packed value of a cell, without any check.
+    //! \param index The cell index (row * size + column).
+    //! \return The cell value, or empty if not set.
+    unsigned char at(unsigned int index) const {
+        return cells[index];
+    }
+
+    //! \brief Set the packed value of a cell, without any check.
+    //! \param index The cell index (row * size + column).
+    //! \param value The cell value, or empty to reset the cell.
+    void set_at(unsigned int index, unsigned char value) {
+        cells[index] = value;
+    }
+
+    //! \brief Get the packed cell values.
+    //! \return size() * size() bytes in row-major order, empty if not set.
+    const unsigned char* data() const {
+        return &cells[0];
+    }
 
     //! \brief Get the grid size.
     //! \return The grid size.
@@ -100,7 +163,27 @@ public:
     //! \return True if both grids are equals.
     bool operator==(const Sudoku& rhs);
 
-    std::string getString();
+    //! \brief Write the compact representation of the grid.
+    //! \param[out] out A buffer of at least size() * size() characters.
+    //! \return The number of characters written, size() * size().
+    //!
+    //! Values are written as '0' to '9' then 'A' to 'O', empty cells as
+    //! 'x', without separator: the output is accepted by parse.
+    std::size_t write(char* out) const;
+
+    //! \brief Write the compact representation of several grids.
+    //! \param first The first grid.
+    //! \param n The number of grids.
+    //! \param[out] out A buffer of at least n * (size() * size() + 1)
+    //!                 characters, for grids of the same size.
+    //! \param separator The character written after each grid.
+    //! \return The number of characters written.
+    static std::size_t write(const Sudoku* first, std::size_t n, char* out,
+                             char separator = '\n');
+
+    //! \brief Get the compact representation of the grid.
+    //! \return The representation written by write.
+    std::string getString() const;
 
     //! \brief Comparaison operator
     //! \param rhs RHS sudoku.
@@ -112,11 +195,11 @@ protected:
     unsigned short grid_size;       /**< Size of the grid: 4x4, 9x9, etc. */
     unsigned short region_num_row;  /**< Vertical size of a region, counted in number rows. */
     unsigned short region_num_col;  /**< Horizontal size of a region, counted in number columns. */
-    std::vector<std::vector<Cell> > cells;  /**< Grid of cells representing the sudoku. */
+    std::vector<unsigned char> cells;   /**< Cell values in row-major order, empty if not set. */
 };
 
-//! \brief operator<< overload to handle Sudoku::Cell.
-std::ostream& operator<<(std::ostream& os, const Sudoku::Cell& cell);
+//! \brief operator<< overload to handle Sudoku cells.
+std::ostream& operator<<(std::ostream& os, const Sudoku::ConstCell& cell);
 
 //! \brief operator<< overload to handle Sudoku.
 std::ostream& operator<<(std::ostream& os, const Sudoku& sudoku);
@@ -8,71 +8,402 @@
 #include <utility>
 
 #include "SudokuSolver.hpp"
+#include "GridValidator.hpp"
+#include "BitmaskSolver.hpp"
+#include "BatchSolver.hpp"
+#include "ParallelSolver.hpp"
+#include "CachingSolver.hpp"
 
 using namespace std;
 
-bool DancingLinksSolver::solve(Sudoku& s) {
-    Node* cover_matrix_root = build_cover_matrix(s);
-    bool solved = solve(cover_matrix_root);
-    delete_cover_matrix(cover_matrix_root);
-    return solved;
+namespace {
+
+//! \brief Get the index of the lowest bit set in a word.
+//! \pre The word is not 0.
+inline unsigned int lowest_bit(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    unsigned int index = 0;
+    for (; !(word & 1); word >>= 1)
+        index++;
+    return index;
+#endif
 }
 
-DancingLinksSolver::Node* DancingLinksSolver::build_cover_matrix(Sudoku& s) {
+} // namespace
 
-    unsigned short s_size = s.size();
-    unsigned int s_num_cells = s_size * s_size;
-    unsigned short s_region_num_rows = s.region_num_rows();
-    unsigned short s_region_num_columns = s.region_num_columns();
+SudokuSolver::~SudokuSolver() {
+}
 
-    unsigned int cm_num_columns = s_num_cells * 4;
-    std::vector<Node*> cm_columns_headers(cm_num_columns);
+SolutionView::SolutionView(unsigned short grid_size, const unsigned int* rows,
+        unsigned int num_rows): size_(grid_size), rows(rows), num_rows(num_rows) {
+}
+
+unsigned short SolutionView::grid_size() const {
+    return size_;
+}
 
-    // Start the build process with the root.
-    Node* cover_matrix_root = new Node;
-    cover_matrix_root->down = cover_matrix_root;
-    cover_matrix_root->up = cover_matrix_root;
-    cover_matrix_root->left = cover_matrix_root;
-    cover_matrix_root->right = cover_matrix_root;
+unsigned int SolutionView::size() const {
+    return num_rows;
+}
 
-    // Fill cm_col_headers with the header nodes.
-    Node* predecessor = cover_matrix_root;
+unsigned int SolutionView::cell_index(unsigned int i) const {
+    return rows[i] / size_;
+}
 
-    for (unsigned int i = 0; i < cm_columns_headers.size(); ++i) {
-        Node* header = new Node;
+unsigned short SolutionView::value(unsigned int i) const {
+    return rows[i] % size_;
+}
 
-        header->up = header->down = header;
-        header->left = predecessor;
-        header->right = cover_matrix_root;
-        header->payload.header.id = i;
-        header->payload.header.count = 0;
+void SolutionView::apply(Sudoku& s) const {
+    for (unsigned int i = 0; i < num_rows; ++i) {
+        s.set_at(cell_index(i), value(i));
+    }
+}
 
-        cover_matrix_root->left = header;
-        predecessor->right = header;
+SolutionVisitor::~SolutionVisitor() {
+}
 
-        cm_columns_headers[i] = header;
-        predecessor = header;
+SearchProgress::~SearchProgress() {
+}
+
+SudokuSolver* SudokuSolver::create(const std::string& name, unsigned int num_threads)
+    throw(std::invalid_argument) {
+
+    if (name == "dlx")
+        return new DancingLinksSolver;
+    if (name == "dlx-stats")
+        return new StatsDancingLinksSolver;
+    if (name == "bitmask")
+        return new BitmaskSolver;
+    if (name == "batch")
+        return new BatchSolver;
+    if (name == "dlx-parallel")
+        return new ParallelDancingLinksSolver(num_threads);
+    if (name == "dlx-cached")
+        return new CachingSolver;
+
+    throw std::invalid_argument("SudokuSolver::create(const std::string&): "
+                                "unknown solver " + name);
+}
+
+template <class Stats>
+BasicDancingLinksSolver<Stats>::BasicDancingLinksSolver():
+    backtracking(false), searched(0), active(0), num_nodes(0), stop_flag(0),
+    num_allocations(0) {
+}
+
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::set_stop_flag(const std::atomic<bool>* flag) {
+    stop_flag = flag;
+}
+
+template <class Stats>
+std::size_t BasicDancingLinksSolver<Stats>::reserved_bytes() const {
+    std::size_t bytes = frames.capacity() * sizeof(Frame) +
+            selected_rows.capacity() * sizeof(unsigned int);
+    typename std::map<std::pair<unsigned short, unsigned short>, CoverMatrix>::const_iterator it;
+    for (it = matrices.begin(); it != matrices.end(); ++it) {
+        const CoverMatrix& cm = it->second;
+        bytes += sizeof(CoverMatrix) +
+                cm.vertical.capacity() * sizeof(VerticalLinks) +
+                cm.horizontal.capacity() * sizeof(HorizontalLinks) +
+                (cm.column.capacity() + cm.count.capacity() +
+                 cm.givens.capacity()) * sizeof(Index) +
+                cm.buckets.capacity() * sizeof(uint64_t);
     }
+    return bytes;
+}
 
-    // In order to fill the cover matrix, go over each cell of the grid.
-    for (unsigned int s_line = 0; s_line < s_size; s_line++) {
-        for (unsigned int s_col = 0; s_col < s_size; s_col++) {
+template <class Stats>
+unsigned int BasicDancingLinksSolver<Stats>::last_solve_allocations() const {
+    return num_allocations;
+}
 
-            // Retrieve the cell at position s_line, s_col.
-            Sudoku::Cell& cell = s.cell(s_line, s_col);
+template <class Stats>
+const Stats& BasicDancingLinksSolver<Stats>::search_stats() const {
+    return stats;
+}
 
-            unsigned short start = 0;
-            unsigned short stop = s_size;
+template <class Stats>
+bool BasicDancingLinksSolver<Stats>::solve(Sudoku& s) {
+    SearchStatus status = start_search(s);
+    if (status == search_suspended)
+        status = resume_search(s, numeric_limits<unsigned long>::max());
+    return status == search_solved;
+}
 
-            if (cell.is_set()) {
-                start = cell.get_value();
-                stop = start + 1;
+template <class Stats>
+typename BasicDancingLinksSolver<Stats>::SearchStatus
+BasicDancingLinksSolver<Stats>::solve_within(Sudoku& s, const CancelToken& token,
+        SearchProgress* progress) {
+    // The token flag stops the search as soon as it backtracks, the
+    // deadline is only checked between slices.
+    const std::atomic<bool>* previous_flag = stop_flag;
+    stop_flag = token.flag();
+
+    SearchStatus status = start_search(s);
+    while (status == search_suspended) {
+        if (token.stop_requested()) {
+            abort_search();
+            status = search_cancelled;
+            break;
+        }
+        status = resume_search(s, nodes_per_slice);
+        if (progress != 0)
+            progress->progress(num_nodes);
+    }
+    if (status == search_unsolvable && token.cancelled())
+        status = search_cancelled;
+
+    stop_flag = previous_flag;
+    return status;
+}
+
+template <class Stats>
+unsigned long BasicDancingLinksSolver<Stats>::count_solutions(const Sudoku& s,
+        unsigned long limit) {
+    abort_search();
+    num_allocations = 0;
+    stats.reset();
+    if (!GridValidator::is_valid(s))
+        return 0;
+    CoverMatrix& cm = cover_matrix(s);
+
+    unsigned long count = 0;
+    if (limit > 0 && apply_givens(cm, s)) {
+        reset_search(cm);
+        unsigned long budget = numeric_limits<unsigned long>::max();
+        while (count < limit && search(budget) == search_solved)
+            count++;
+        unwind_search();
+    }
+    remove_givens(cm);
+    return count;
+}
+
+template <class Stats>
+bool BasicDancingLinksSolver<Stats>::has_solution_without(const Sudoku& s,
+        unsigned int index, unsigned short value) {
+    abort_search();
+    num_allocations = 0;
+    stats.reset();
+    // A given holding the value is in every solution.
+    if (!GridValidator::is_valid(s) || s.at(index) == value)
+        return false;
+    CoverMatrix& cm = cover_matrix(s);
+
+    bool found = false;
+    if (apply_givens(cm, s)) {
+        // Take the row out of its columns, unless a given already did:
+        // covering a column unlinks the rows crossing it from the others.
+        VerticalLinks* vertical = &cm.vertical[0];
+        const HorizontalLinks* horizontal = &cm.horizontal[0];
+        Index row = cm.row_node(index * cm.size + value);
+        bool in_matrix = true;
+        Index row_el = row;
+        do {
+            Index header = cm.column[row_el];
+            if (horizontal[horizontal[header].left].right != header)
+                in_matrix = false;
+            row_el = horizontal[row_el].right;
+        } while (row_el != row);
+
+        if (in_matrix) {
+            row_el = row;
+            do {
+                vertical[vertical[row_el].up].down = vertical[row_el].down;
+                vertical[vertical[row_el].down].up = vertical[row_el].up;
+                decrement_count(cm.column[row_el]);
+                row_el = horizontal[row_el].right;
+            } while (row_el != row);
+        }
+
+        reset_search(cm);
+        unsigned long budget = numeric_limits<unsigned long>::max();
+        found = search(budget) == search_solved;
+        unwind_search();
+
+        if (in_matrix) {
+            Index last = horizontal[row].left;
+            row_el = last;
+            do {
+                vertical[vertical[row_el].up].down = row_el;
+                vertical[vertical[row_el].down].up = row_el;
+                increment_count(cm.column[row_el]);
+                row_el = horizontal[row_el].left;
+            } while (row_el != last);
+        }
+    }
+    remove_givens(cm);
+    return found;
+}
+
+template <class Stats>
+unsigned long BasicDancingLinksSolver<Stats>::enumerate_solutions(const Sudoku& s,
+        SolutionVisitor& visitor) {
+    abort_search();
+    num_allocations = 0;
+    stats.reset();
+    if (!GridValidator::is_valid(s))
+        return 0;
+    CoverMatrix& cm = cover_matrix(s);
+
+    unsigned int num_cells = cm.size * cm.size;
+    if (selected_rows.capacity() < num_cells) {
+        selected_rows.reserve(num_cells);
+        num_allocations++;
+    }
+
+    unsigned long count = 0;
+    if (apply_givens(cm, s)) {
+        reset_search(cm);
+        unsigned long budget = numeric_limits<unsigned long>::max();
+        while (search(budget) == search_solved) {
+            // The givens, then the rows on the search stack.
+            selected_rows.clear();
+            for (typename vector<Index>::const_iterator it = cm.givens.begin();
+                    it != cm.givens.end(); ++it) {
+                selected_rows.push_back(cm.row_of(*it));
+            }
+            for (typename vector<Frame>::const_iterator it = frames.begin();
+                    it != frames.end(); ++it) {
+                selected_rows.push_back(cm.row_of(it->row));
             }
 
+            count++;
+            if (!visitor.visit(SolutionView(cm.size, &selected_rows[0],
+                                            selected_rows.size())))
+                break;
+        }
+        unwind_search();
+    }
+    remove_givens(cm);
+    return count;
+}
+
+template <class Stats>
+typename BasicDancingLinksSolver<Stats>::SearchStatus
+BasicDancingLinksSolver<Stats>::start_search(const Sudoku& s) {
+    abort_search();
+    num_allocations = 0;
+    stats.reset();
+    num_nodes = 0;
+    if (!GridValidator::is_valid(s))
+        return search_unsolvable;
+    CoverMatrix& cm = cover_matrix(s);
+
+    if (!apply_givens(cm, s)) {
+        remove_givens(cm);
+        return search_unsolvable;
+    }
+    reset_search(cm);
+    searched = &cm;
+    return search_suspended;
+}
+
+template <class Stats>
+typename BasicDancingLinksSolver<Stats>::SearchStatus
+BasicDancingLinksSolver<Stats>::resume_search(Sudoku& s, unsigned long max_nodes) {
+    if (searched == 0)
+        return search_unsolvable;
+
+    unsigned long budget = max_nodes;
+    SearchStatus status = search(budget);
+    num_nodes += max_nodes - budget;
+    if (status == search_suspended)
+        return status;
+
+    if (status == search_solved)
+        write_solution(s);
+    abort_search();
+    return status;
+}
+
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::abort_search() {
+    if (searched == 0)
+        return;
+    unwind_search();
+    remove_givens(*searched);
+    searched = 0;
+}
+
+template <class Stats>
+bool BasicDancingLinksSolver<Stats>::searching() const {
+    return searched != 0;
+}
+
+template <class Stats>
+unsigned long long BasicDancingLinksSolver<Stats>::search_nodes() const {
+    return num_nodes;
+}
+
+template <class Stats>
+typename BasicDancingLinksSolver<Stats>::CoverMatrix& BasicDancingLinksSolver<Stats>::cover_matrix(const Sudoku& s) {
+    std::pair<unsigned short, unsigned short> geometry = s.region_size();
+
+    typename std::map<std::pair<unsigned short, unsigned short>, CoverMatrix>::iterator it =
+            matrices.find(geometry);
+    if (it != matrices.end()) {
+        active = &it->second;
+        return it->second;
+    }
+
+    CoverMatrix& cm = matrices[geometry];
+    stats.start_build();
+    build_cover_matrix(cm, s);
+    stats.stop_build();
+    return cm;
+}
+
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::build_cover_matrix(CoverMatrix& cm, const Sudoku& s) {
+
+    unsigned short s_size = s.size();
+    unsigned int s_num_cells = s_size * s_size;
+    unsigned short s_region_num_rows = s.region_num_rows();
+    unsigned short s_region_num_columns = s.region_num_columns();
+
+    unsigned int cm_num_columns = s_num_cells * 4;
+    unsigned int cm_num_rows = s_num_cells * s_size;
+
+    // The matrix holds the root, the headers and four nodes
+    // for every value of every cell.
+    unsigned int cm_num_nodes = 1 + cm_num_columns + 4 * cm_num_rows;
+    cm.size = s_size;
+    cm.num_columns = cm_num_columns;
+    cm.vertical.resize(cm_num_nodes);
+    cm.horizontal.resize(cm_num_nodes);
+    cm.column.resize(cm_num_nodes);
+    cm.count.assign(cm_num_columns + 1, 0);
+    cm.givens.reserve(s_num_cells);
+    cm.bucket_words = (cm_num_columns + 63) / 64;
+    cm.buckets.assign(cm.bucket_words * (s_size + 1), 0);
+    num_allocations += 6;
+    active = &cm;
+
+    VerticalLinks* vertical = &cm.vertical[0];
+    HorizontalLinks* horizontal = &cm.horizontal[0];
+
+    // The root and the headers form the header row, in column id order.
+    for (unsigned int node = 0; node <= cm_num_columns; ++node) {
+        vertical[node].up = vertical[node].down = node;
+        horizontal[node].left = node == 0 ? cm_num_columns : node - 1;
+        horizontal[node].right = node == cm_num_columns ? 0 : node + 1;
+        cm.column[node] = node;
+    }
+
+    // In order to fill the cover matrix, go over each cell of the grid.
+    for (unsigned int s_line = 0; s_line < s_size; s_line++) {
+        for (unsigned int s_col = 0; s_col < s_size; s_col++) {
+
+            unsigned int index = s_line * s_size + s_col;
+
             // For each value in the cell domain, add a row to the cover matrix.
-            for (unsigned int value = start; value < stop; value++) {
+            for (unsigned int value = 0; value < s_size; value++) {
 
-                //std::vector<unsigned int> pos_col(4);
                 unsigned int pos_col[4];
 
                 // Calculate new node positions in the cover matrix
@@ -85,176 +416,330 @@ DancingLinksSolver::Node* DancingLinksSolver::build_cover_matrix(Sudoku& s) {
                         + s_col/s_region_num_columns * s_region_num_columns);
                 pos_col[3] = s_num_cells*3 + s_region * s_size + value;
 
-                // Build the first node of the row separately because
-                // it needs special care for its left and right pointers.
-                Node* header = cm_columns_headers[pos_col[0]];
-                Node* first = new Node;
-
-                // Set up the first node.
-                first->payload.cell.cellptr = &cell;
-                first->payload.cell.value = value;
-                first->header = header;
-                first->up = header->up;
-                first->down = header;
-                first->left = first;
-                first->right = first;
-
-                // Update neighbours of the first node.
-                first->up->down = first;
-                header->up = first;
-                header->payload.header.count++;
-
-                // At the begining, the first node in
-                // the row is also the last.
-                Node* last = first;
-
-                // Then, build the rest of the row.
-                for (unsigned int i = 1; i < 4; ++i) {
-                    Node* header = cm_columns_headers[pos_col[i]];
-                    Node* current = new Node;
-
-                    // Set up the current node.
-                    current->payload.cell.cellptr = &cell;
-                    current->payload.cell.value = value;
-                    current->header = header;
-                    current->up = header->up;
-                    current->down = header;
-                    current->left = last;
-                    current->right = first;
-
-                    // Update current node neighbours.
-                    current->up->down = current;
-                    current->left->right = current;
-                    header->up = current;
-                    first->left = current;
-                    header->payload.header.count++;
-
-                    // Set the current node as the last node of the row.
-                    last = current;
+                // The four nodes of the row are consecutive, each one is
+                // appended at the bottom of its column.
+                Index first = cm.row_node(index * s_size + value);
+                for (unsigned int i = 0; i < 4; ++i) {
+                    Index header = pos_col[i] + 1;
+                    Index current = first + i;
+
+                    cm.column[current] = header;
+                    vertical[current].up = vertical[header].up;
+                    vertical[current].down = header;
+                    vertical[vertical[header].up].down = current;
+                    vertical[header].up = current;
+                    horizontal[current].left = i == 0 ? first + 3 : current - 1;
+                    horizontal[current].right = i == 3 ? first : current + 1;
+                    cm.count[header]++;
                 }
             }
         }
     }
-    return cover_matrix_root;
-}
-
-void DancingLinksSolver::delete_cover_matrix(Node* root) {
-    Node* header = root->right;
-    // Go over each header of the cover matrix.
-    while (header != root) {
-        Node* col_el = header->down;
-        // Then, go over each element of
-        // the corresponding column.
-        while (col_el != header) {
-            Node* old_col_el = col_el;
-            col_el = col_el->down;
-            delete old_col_el;
-        }
-        Node* old_header = header;
-        header = header->right;
-        delete old_header;
-    }
-    // Finally, delete the root node.
-    delete root;
+
+    // Every column starts in the bucket of the grid size.
+    for (unsigned int header = 1; header <= cm_num_columns; ++header)
+        link_bucket(header);
 }
 
-bool DancingLinksSolver::solve(Node* root) {
-    bool solved = false;
-    // node* column_header = root->right; // slow !!!
-    Node* column_header = choose_next_column(root);
+template <class Stats>
+bool BasicDancingLinksSolver<Stats>::apply_givens(CoverMatrix& cm, const Sudoku& s) {
+    cm.givens.clear();
+    const HorizontalLinks* horizontal = &cm.horizontal[0];
+
+    unsigned int num_cells = cm.size * cm.size;
+    for (unsigned int index = 0; index < num_cells; index++) {
+        unsigned int value = s.at(index);
+        if (value == Sudoku::empty)
+            continue;
+
+        Index row = cm.row_node(index * cm.size + value);
+
+        // A row is still in the matrix as long as none of its
+        // columns is covered. A covered header is unlinked from
+        // the header row, so its left neighbour no longer sees it.
+        Index row_el = row;
+        do {
+            Index header = cm.column[row_el];
+            if (horizontal[horizontal[header].left].right != header)
+                return false;
+            row_el = horizontal[row_el].right;
+        } while (row_el != row);
+
+        select_row(row);
+        cm.givens.push_back(row);
+    }
+    return true;
+}
 
-    if (column_header == root)
-        return true;
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::remove_givens(CoverMatrix& cm) {
+    // Unselect in reverse order so that every link is restored.
+    while (!cm.givens.empty()) {
+        unselect_row(cm.givens.back());
+        cm.givens.pop_back();
+    }
+}
 
-    cover_column(column_header);
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::select_row(Index row) {
+    const HorizontalLinks* horizontal = &active->horizontal[0];
+    Index row_el = row;
+    do {
+        cover_column(active->column[row_el]);
+        row_el = horizontal[row_el].right;
+    } while (row_el != row);
+}
 
-    Node* column_element = column_header->down;
-    while (column_element != column_header) {
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::unselect_row(Index row) {
+    const HorizontalLinks* horizontal = &active->horizontal[0];
+    Index last = horizontal[row].left;
+    Index row_el = last;
+    do {
+        uncover_column(active->column[row_el]);
+        row_el = horizontal[row_el].left;
+    } while (row_el != last);
+}
 
-        Node* row_element = column_element->right;
-        while (row_element != column_element) {
-            cover_column(row_element->header);
-            row_element = row_element->right;
-        }
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::reset_search(const CoverMatrix& cm) {
+    // The search selects at most one row per cell.
+    unsigned int num_cells = cm.size * cm.size;
+    if (frames.capacity() < num_cells) {
+        frames.reserve(num_cells);
+        num_allocations++;
+    }
+    frames.clear();
+    backtracking = false;
+}
 
-        solved = solve(root);
+template <class Stats>
+typename BasicDancingLinksSolver<Stats>::SearchStatus
+BasicDancingLinksSolver<Stats>::search(unsigned long& budget) {
+    const VerticalLinks* vertical = &active->vertical[0];
+    const HorizontalLinks* horizontal = &active->horizontal[0];
+    const Index* column = &active->column[0];
+
+    // Every frame on the stack has its column covered and, unless it is
+    // still on the header, its row selected.
+    for (;;) {
+        if (backtracking) {
+            if (frames.empty())
+                return search_unsolvable;
+            if (stop_flag != 0 && stop_flag->load(std::memory_order_relaxed))
+                return search_unsolvable;
+
+            // The subtree of the top row is done: undo the row.
+            Index column_element = frames.back().row;
+            Index row_element = horizontal[column_element].left;
+            while (row_element != column_element) {
+                uncover_column(column[row_element]);
+                row_element = horizontal[row_element].left;
+            }
+            stats.backtrack();
+        } else {
+            if (budget == 0)
+                return search_suspended;
+            budget--;
+
+            Index column_header = choose_next_column();
+
+            // Every column is covered: the stack holds a solution, and
+            // running the search again looks for the next one.
+            if (column_header == 0) {
+                backtracking = true;
+                return search_solved;
+            }
+            // No row left to cover this column: dead end.
+            if (active->count[column_header] == 0) {
+                backtracking = true;
+                continue;
+            }
 
-        row_element = column_element->left;
-        while (row_element != column_element) {
-            uncover_column(row_element->header);
-            row_element = row_element->left;
+            stats.enter();
+            cover_column(column_header);
+            Frame frame = { column_header, column_header };
+            frames.push_back(frame);
         }
 
-        // If we've solved the exact cover problem,
-        // set the cell value accordingly.
-        if (solved) {
-            unsigned int cell_value = column_element->payload.cell.value;
-            Sudoku::Cell* cell = column_element->payload.cell.cellptr;
-            cell->set_value(cell_value);
-            break;
+        // Select the next row of the top node, or leave the node once
+        // every row was tried.
+        Frame& frame = frames.back();
+        frame.row = vertical[frame.row].down;
+        if (frame.row == frame.header) {
+            uncover_column(frame.header);
+            stats.leave();
+            frames.pop_back();
+            backtracking = true;
+        } else {
+            Index row_element = horizontal[frame.row].right;
+            while (row_element != frame.row) {
+                cover_column(column[row_element]);
+                row_element = horizontal[row_element].right;
+            }
+            backtracking = false;
         }
-
-        column_element = column_element->down;
     }
-
-    uncover_column(column_header);
-    return solved;
 }
 
-DancingLinksSolver::Node* DancingLinksSolver::choose_next_column(Node* root) {
-
-    unsigned int lower_header_count = std::numeric_limits<unsigned int>::max();
-
-    Node* current_header = root->right;
-    Node* next_header = current_header;
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::unwind_search() {
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (frame.row != frame.header) {
+            const HorizontalLinks* horizontal = &active->horizontal[0];
+            Index row_element = horizontal[frame.row].left;
+            while (row_element != frame.row) {
+                uncover_column(active->column[row_element]);
+                row_element = horizontal[row_element].left;
+            }
+        }
+        uncover_column(frame.header);
+        stats.leave();
+        frames.pop_back();
+    }
+    backtracking = false;
+}
 
-    while (current_header != root) {
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::write_solution(Sudoku& s) const {
+    for (typename vector<Frame>::const_iterator it = frames.begin();
+            it != frames.end(); ++it) {
+        unsigned int row = active->row_of(it->row);
+        s.set_at(row / active->size, row % active->size);
+    }
+}
 
-        unsigned int header_count = current_header->payload.header.count;
-        if (header_count < lower_header_count) {
-            lower_header_count = header_count;
-            next_header = current_header;
+template <class Stats>
+typename BasicDancingLinksSolver<Stats>::Index BasicDancingLinksSolver<Stats>::choose_next_column() {
+    stats.start_choose();
+    Index next_header = 0;
+    const uint64_t* bits = &active->buckets[0];
+    unsigned int num_words = active->bucket_words * (active->size + 1);
+
+    // The buckets are stored by increasing count, and the lowest id of
+    // a bucket is the first of its columns in the header row.
+    for (unsigned int word = 0; word < num_words; ++word) {
+        if (bits[word] != 0) {
+            unsigned int id = word % active->bucket_words * 64 + lowest_bit(bits[word]);
+            next_header = id + 1;
+            break;
         }
-
-        current_header = current_header->right;
     }
+    stats.stop_choose();
     return next_header;
 }
 
-void DancingLinksSolver::cover_column(Node* header) {
-    // Remove the header from the header row.
-    header->left->right = header->right;
-    header->right->left = header->left;
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::cover_column(Index header) {
+    VerticalLinks* vertical = &active->vertical[0];
+    HorizontalLinks* horizontal = &active->horizontal[0];
+    const Index* column = &active->column[0];
+    Index* count = &active->count[0];
+    uint64_t* buckets = &active->buckets[0];
+    unsigned int words = active->bucket_words;
+
+    // Remove the header from the header row and from its bucket.
+    horizontal[horizontal[header].left].right = horizontal[header].right;
+    horizontal[horizontal[header].right].left = horizontal[header].left;
+    unlink_bucket(header);
+    unsigned int links = 2;
     // Go over each column elements.
-    Node* col_el = header->down;
+    Index col_el = vertical[header].down;
     while (col_el != header) {
         // Remove each neighbour elements in the
         // row of the current column element.
-        Node* row_el = col_el->right;
+        Index row_el = horizontal[col_el].right;
         while (row_el != col_el) {
-            row_el->up->down = row_el->down;
-            row_el->down->up = row_el->up;
-            row_el->header->payload.header.count--;
-            row_el = row_el->right;
+            VerticalLinks links_el = vertical[row_el];
+            vertical[links_el.up].down = links_el.down;
+            vertical[links_el.down].up = links_el.up;
+            // decrement_count, with the arrays kept in locals.
+            unsigned int id = column[row_el] - 1;
+            uint64_t* word = &buckets[count[id + 1]-- * words + id / 64];
+            uint64_t bit = uint64_t(1) << (id % 64);
+            *word &= ~bit;
+            *(word - words) |= bit;
+            row_el = horizontal[row_el].right;
+            links += 2;
         }
-        col_el = col_el->down;
+        col_el = vertical[col_el].down;
     }
+    stats.cover(links);
 }
 
-void DancingLinksSolver::uncover_column(Node* header) {
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::uncover_column(Index header) {
+    VerticalLinks* vertical = &active->vertical[0];
+    HorizontalLinks* horizontal = &active->horizontal[0];
+    const Index* column = &active->column[0];
+    Index* count = &active->count[0];
+    uint64_t* buckets = &active->buckets[0];
+    unsigned int words = active->bucket_words;
+
+    unsigned int links = 2;
     // Go over each element in the column.
-    Node* col_el = header->up;
+    Index col_el = vertical[header].up;
     while (col_el != header) {
-        Node* row_el = col_el->left;
+        Index row_el = horizontal[col_el].left;
         while (row_el != col_el) {
-            row_el->up->down = row_el;
-            row_el->down->up = row_el;
-            row_el->header->payload.header.count++;
-            row_el = row_el->left;
+            VerticalLinks links_el = vertical[row_el];
+            vertical[links_el.up].down = row_el;
+            vertical[links_el.down].up = row_el;
+            // increment_count, with the arrays kept in locals.
+            unsigned int id = column[row_el] - 1;
+            uint64_t* word = &buckets[count[id + 1]++ * words + id / 64];
+            uint64_t bit = uint64_t(1) << (id % 64);
+            *word &= ~bit;
+            *(word + words) |= bit;
+            row_el = horizontal[row_el].left;
+            links += 2;
         }
-        col_el = col_el->up;
+        col_el = vertical[col_el].up;
     }
-    // Reinsert the header in its row.
-    header->left->right = header;
-    header->right->left = header;
+    // Reinsert the header in its row and in its bucket.
+    horizontal[horizontal[header].left].right = header;
+    horizontal[horizontal[header].right].left = header;
+    link_bucket(header);
+    stats.uncover(links);
+}
+
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::unlink_bucket(Index header) {
+    unsigned int id = header - 1;
+    unsigned int count = active->count[header];
+    active->buckets[count * active->bucket_words + id / 64] &= ~(uint64_t(1) << (id % 64));
 }
+
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::link_bucket(Index header) {
+    unsigned int id = header - 1;
+    unsigned int count = active->count[header];
+    active->buckets[count * active->bucket_words + id / 64] |= uint64_t(1) << (id % 64);
+}
+
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::decrement_count(Index header) {
+    // The column moves from its bucket to the one before: the same bit
+    // of the previous bitset.
+    unsigned int id = header - 1;
+    unsigned int count = active->count[header]--;
+    uint64_t* word = &active->buckets[count * active->bucket_words + id / 64];
+    uint64_t bit = uint64_t(1) << (id % 64);
+    *word &= ~bit;
+    *(word - active->bucket_words) |= bit;
+}
+
+template <class Stats>
+void BasicDancingLinksSolver<Stats>::increment_count(Index header) {
+    unsigned int id = header - 1;
+    unsigned int count = active->count[header]++;
+    uint64_t* word = &active->buckets[count * active->bucket_words + id / 64];
+    uint64_t bit = uint64_t(1) << (id % 64);
+    *word &= ~bit;
+    *(word + active->bucket_words) |= bit;
+}
+
+// The solver is only instantiated for the stats policies of SearchStats.hpp.
+template class BasicDancingLinksSolver<NoStats>;
+template class BasicDancingLinksSolver<SearchStats>;
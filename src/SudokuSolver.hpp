@@ -12,44 +12,203 @@
 #pragma warning(disable: 4290)
 
 #include <deque>
+#include <vector>
+#include <map>
+#include <utility>
+#include <cstddef>
+#include <atomic>
+#include <string>
+#include <stdexcept>
+#include <stdint.h>
 
 #include "Sudoku.hpp"
+#include "SearchStats.hpp"
+#include "CancelToken.hpp"
 
 //! Sudoku solvers base class.
 class SudokuSolver {
 public:
+    //! \brief SudokuSolver destructor.
+    virtual ~SudokuSolver();
+
+    //! \brief Create a solver from its name.
+    //! \param name The solver name: "dlx" (dancing links), "dlx-stats"
+    //!             (dancing links, with search statistics), "dlx-parallel"
+    //!             (dancing links, one grid on every core), "dlx-cached"
+    //!             (dancing links, remembering solutions, see CachingSolver),
+    //!             "bitmask" (constraint propagation) or "batch" (SIMD
+    //!             propagation, see BatchSolver::solve_batch).
+    //! \param num_threads Threads a solver searching one grid on several
+    //!        threads may use, 0 for one per core.
+    //! \return A new solver, to be deleted by the caller.
+    static SudokuSolver* create(const std::string& name, unsigned int num_threads = 0)
+        throw(std::invalid_argument);
+
     //! \brief Solve a sudoku grid.
     //! \param[out] sudoku The sudoku grid to solve.
     //! \return True if the grid was completely solved, false otherwise.
     virtual bool solve(Sudoku& sudoku) = 0;
 };
 
+//! \brief Read-only view of a solution found by a search.
+//!
+//! The view lists the value of every cell, in no particular order. It is
+//! only valid during the SolutionVisitor::visit call which receives it.
+class SolutionView {
+public:
+    //! \brief SolutionView constructor.
+    //! \param grid_size The grid size.
+    //! \param rows The selected values, as cell index * grid_size + value.
+    //! \param num_rows The number of selected values.
+    SolutionView(unsigned short grid_size, const unsigned int* rows,
+                 unsigned int num_rows);
+
+    //! \brief Get the grid size.
+    //! \return The grid size.
+    unsigned short grid_size() const;
+
+    //! \brief Get the number of values in the solution.
+    //! \return The number of cells in the grid.
+    unsigned int size() const;
+
+    //! \brief Get the cell of a value.
+    //! \param i The value position in the view.
+    //! \return The cell index (row * grid size + column).
+    unsigned int cell_index(unsigned int i) const;
+
+    //! \brief Get a value.
+    //! \param i The value position in the view.
+    //! \return The value of the cell.
+    unsigned short value(unsigned int i) const;
+
+    //! \brief Copy the solution into a grid.
+    //! \param[out] s A grid of the same size.
+    void apply(Sudoku& s) const;
+
+protected:
+    unsigned short size_;       /**< The grid size. */
+    const unsigned int* rows;   /**< The selected values. */
+    unsigned int num_rows;      /**< The number of selected values. */
+};
+
+//! \brief Receiver of the solutions enumerated by a solver.
+class SolutionVisitor {
+public:
+    //! \brief SolutionVisitor destructor.
+    virtual ~SolutionVisitor();
+
+    //! \brief Receive a solution.
+    //! \param solution The solution, only valid during the call.
+    //! \return True to continue the enumeration, false to stop it.
+    virtual bool visit(const SolutionView& solution) = 0;
+};
+
+//! \brief Receiver of the progress of a long search.
+class SearchProgress {
+public:
+    //! \brief SearchProgress destructor.
+    virtual ~SearchProgress();
+
+    //! \brief Receive the progress of the search, after each slice.
+    //! \param nodes The number of search nodes visited so far.
+    virtual void progress(unsigned long long nodes) = 0;
+};
+
 //! \brief Sudoku solver based on the dancing links algorithm.
-class DancingLinksSolver: public SudokuSolver {
+//! \tparam Stats The stats policy the search reports to (see
+//!               SearchStats.hpp): NoStats costs nothing.
+//!
+//! The cover matrix only depends on the grid geometry: the solver keeps
+//! one fully built matrix per geometry it has seen and applies the grid
+//! predefined values by covering their rows before each search.
+//!
+//! The search doesn't recurse: the path from the root of the search tree
+//! is kept on an explicit stack, preallocated to the number of cells, so
+//! a search can be suspended after a number of nodes and resumed later
+//! (see start_search). A solver runs one search at a time; to interleave
+//! several searches on a thread, give each its own solver.
+template <class Stats>
+class BasicDancingLinksSolver: public SudokuSolver {
 protected:
-    //! \brief Cover matrix node.
+    //! \brief Index of a cover matrix node.
     //!
-    //! Nodes are both used to represent column headers and column
-    //! elements. The payload element is handled differently.
-    struct Node {
-        Node* up;       /**< Pointer to the up node. */
-        Node* down;     /**< Pointer to the down node. */
-        Node* left;     /**< Pointer to the left node. */
-        Node* right;    /**< Pointer to the right node. */
-        Node* header;   /**< Pointer to the column header. */
-        union {
-            struct {
-                Sudoku::Cell* cellptr;  /**< Pointer to the corresponding sudoku grid cell. */
-                unsigned int value;     /**< Value represented by this matrix element. */
-            } cell;     /**< Associated data for standard nodes (matrix element). */
-            struct {
-                unsigned int count;     /**< Number of elements in the column. */
-                unsigned int id;        /**< Column id.  */
-            } header;   /**< Associated data for header node. */
-        } payload;      /**< The node associated data. */
+    //! Node 0 is the root, nodes 1 to the number of columns are the column
+    //! headers, then each row has four consecutive nodes. A 25x25 grid
+    //! has 1 + 2500 + 4 * 15625 = 65001 nodes, so 16 bits are enough for
+    //! every geometry.
+    typedef uint16_t Index;
+
+    //! \brief Links of a node in its column.
+    struct VerticalLinks {
+        Index up;       /**< Index of the up node. */
+        Index down;     /**< Index of the down node. */
+    };
+
+    //! \brief Links of a node in its row, or of a header in the header row.
+    struct HorizontalLinks {
+        Index left;     /**< Index of the left node. */
+        Index right;    /**< Index of the right node. */
+    };
+
+    //! \brief Cover matrix of an empty grid of a given geometry.
+    //!
+    //! The nodes are stored as parallel arrays of 16 bit indices rather
+    //! than as structures of pointers: a 9x9 matrix takes 32 KB instead of
+    //! 155 KB, and cover_column only touches the arrays it updates. A node
+    //! row follows from its index, no cell index or value is stored.
+    //!
+    //! The uncovered columns are also kept in buckets by element count,
+    //! from 0 to the grid size, so that the column with the fewest
+    //! elements is found without going over the header row. A bucket is
+    //! a bitset of column ids: its lowest id is the first of its columns
+    //! in the header row.
+    struct CoverMatrix {
+        unsigned short size;        /**< Size of the corresponding grid. */
+        unsigned int num_columns;   /**< Number of columns. */
+        std::vector<VerticalLinks> vertical;        /**< Up and down links of each node. */
+        std::vector<HorizontalLinks> horizontal;    /**< Left and right links of each node. */
+        std::vector<Index> column;  /**< Column header of each node. */
+        std::vector<Index> count;   /**< Number of elements of each column, by header. */
+        std::vector<Index> givens;  /**< Rows selected for the predefined values of the grid being solved. */
+        unsigned int bucket_words;  /**< Number of words of a bucket bitset. */
+        std::vector<uint64_t> buckets;  /**< Bitset of each bucket, by increasing count. */
+
+        //! \brief Get the first node of a row.
+        //! \param row The row, as cell index * size + value.
+        Index row_node(unsigned int row) const {
+            return static_cast<Index>(1 + num_columns + 4 * row);
+        }
+
+        //! \brief Get the row of a node.
+        //! \param node A node which isn't the root or a header.
+        //! \return The row, as cell index * size + value.
+        unsigned int row_of(Index node) const {
+            return (node - 1 - num_columns) / 4;
+        }
+    };
+
+    //! \brief Search tree node on the search stack.
+    struct Frame {
+        Index header;   /**< Header of the column covered by the node. */
+        Index row;      /**< Row being tried, the header before the first one. */
     };
 
 public:
+    //! \brief Outcome of a resumable search.
+    enum SearchStatus {
+        search_solved,      /**< A solution was found. */
+        search_unsolvable,  /**< The grid has no solution, or the search was stopped. */
+        search_suspended,   /**< The node budget ran out, the search can be resumed. */
+        search_cancelled    /**< The search was cancelled or ran past its deadline. */
+    };
+
+    //! \brief Number of nodes solve_within visits between two checks of
+    //!        its token deadline and two progress reports.
+    static const unsigned long nodes_per_slice = 4096;
+
+    //! \brief BasicDancingLinksSolver constructor.
+    BasicDancingLinksSolver();
+
     //! \brief Solve a sudoku grid.
     //! \param[out] s The sudoku grid to solve.
     //! \return True if the grid was solved, false otherwise.
@@ -57,35 +216,202 @@ public:
     //! The grid won't be modified modified if no solution are found.
     bool solve(Sudoku& s);
 
+    //! \brief Solve a sudoku grid, unless cancelled or out of time.
+    //! \param[out] s The sudoku grid to solve.
+    //! \param token The token cancelling the search, also giving its deadline.
+    //! \param progress Receives the number of nodes visited after each
+    //!                 slice of the search, may be null.
+    //! \return search_solved, search_unsolvable or search_cancelled.
+    //!
+    //! The grid won't be modified if no solution is found. The stop flag
+    //! is replaced by the token one during the search.
+    SearchStatus solve_within(Sudoku& s, const CancelToken& token,
+                              SearchProgress* progress = 0);
+
+    //! \brief Count the solutions of a grid, up to a limit.
+    //! \param s The sudoku grid, left untouched.
+    //! \param limit The search stops once that many solutions are found.
+    //! \return The number of solutions, at most limit.
+    //!
+    //! A limit of 2 checks that a grid has a unique solution.
+    unsigned long count_solutions(const Sudoku& s, unsigned long limit);
+
+    //! \brief Check whether a grid has a solution where a cell doesn't
+    //!        hold a given value.
+    //! \param s The sudoku grid, left untouched.
+    //! \param index The cell index (row * size + column).
+    //! \param value The value the cell mustn't hold.
+    //! \return True if such a solution exists, false if the cell is given
+    //!         that value.
+    //!
+    //! When a clue is removed from a grid with a unique solution, the
+    //! solution stays unique unless the grid has one without that clue:
+    //! this is a single search for any solution, cheaper than counting
+    //! up to 2.
+    bool has_solution_without(const Sudoku& s, unsigned int index,
+                              unsigned short value);
+
+    //! \brief Enumerate the solutions of a grid.
+    //! \param s The sudoku grid, left untouched.
+    //! \param visitor The visitor receiving each solution.
+    //! \return The number of solutions visited.
+    //!
+    //! The solutions are streamed to the visitor as they are found, the
+    //! memory used doesn't depend on their number.
+    unsigned long enumerate_solutions(const Sudoku& s, SolutionVisitor& visitor);
+
+    //! \brief Start a resumable search.
+    //! \param s The sudoku grid to solve, left untouched.
+    //! \return search_unsolvable if two predefined values conflict,
+    //!         search_suspended otherwise.
+    //!
+    //! Grids with conflicting values are rejected by GridValidator before
+    //! any cover matrix work, here as in solve, count_solutions,
+    //! has_solution_without and enumerate_solutions.
+    //!
+    //! A search in progress is abandoned, as it is by solve,
+    //! count_solutions and enumerate_solutions.
+    SearchStatus start_search(const Sudoku& s);
+
+    //! \brief Continue the search in progress.
+    //! \param[out] s The grid given to start_search, receives the solution.
+    //! \param max_nodes The number of search nodes to visit before the
+    //!                  search is suspended.
+    //! \return search_suspended if the node budget ran out. Otherwise the
+    //!         search is over and s is only modified if it is solved.
+    SearchStatus resume_search(Sudoku& s, unsigned long max_nodes);
+
+    //! \brief Abandon the search in progress, if any.
+    void abort_search();
+
+    //! \brief Query whether a search is in progress.
+    //! \return True between start_search and the end of the search.
+    bool searching() const;
+
+    //! \brief Get the number of nodes visited by the resumable search.
+    //! \return The nodes visited since the last start_search.
+    unsigned long long search_nodes() const;
+
+    //! \brief Set a flag which stops the search when raised.
+    //! \param flag The flag, may be raised from another thread;
+    //!             null to never stop.
+    //!
+    //! A stopped search reports that no solution was found.
+    void set_stop_flag(const std::atomic<bool>* flag);
+
+    //! \brief Get the memory held by the solver between solves.
+    //! \return The number of bytes reserved for cover matrices.
+    std::size_t reserved_bytes() const;
+
+    //! \brief Get the number of heap allocations made by the last solve.
+    //! \return The allocation count, 0 once the solver has built the
+    //!         cover matrix for the geometry of the grids being solved.
+    unsigned int last_solve_allocations() const;
+
+    //! \brief Get the statistics of the last search.
+    //! \return The stats of the last solve, count_solutions or
+    //!         enumerate_solutions call.
+    const Stats& search_stats() const;
+
 protected:
 
-    //! \brief Build the cover matrix corresponding to a given sudoku grid.
+    //! \brief Get the cover matrix for the geometry of a given grid.
     //! \param s A sudoku grid.
-    //! \return A pointer to the root node of the cover matrix.
-    Node* build_cover_matrix(Sudoku& s);
+    //! \return The cover matrix, built on first use.
+    CoverMatrix& cover_matrix(const Sudoku& s);
+
+    //! \brief Build the cover matrix of an empty grid.
+    //! \param[out] cm The cover matrix to build.
+    //! \param s A sudoku grid giving the geometry.
+    void build_cover_matrix(CoverMatrix& cm, const Sudoku& s);
+
+    //! \brief Select the rows of the grid predefined values.
+    //! \param cm The cover matrix of the grid geometry.
+    //! \param s A sudoku grid.
+    //! \return False if two predefined values conflict.
+    //! \post The selected rows are recorded in cm.givens, even on failure.
+    bool apply_givens(CoverMatrix& cm, const Sudoku& s);
+
+    //! \brief Restore the rows removed by apply_givens.
+    //! \param cm The cover matrix of the grid geometry.
+    void remove_givens(CoverMatrix& cm);
+
+    //! \brief Select a row: cover each column it has a node in.
+    //! \param row A node of the row.
+    void select_row(Index row);
+
+    //! \brief Unselect a row, undoing select_row.
+    //! \param row The node given to select_row.
+    void unselect_row(Index row);
+
+    //! \brief Prepare the search stack for a new search.
+    //! \param cm The cover matrix searched, its givens already applied.
+    void reset_search(const CoverMatrix& cm);
+
+    //! \brief Run the search from its current state, on the active matrix.
+    //! \param[in,out] budget The number of nodes left to visit.
+    //! \return search_solved with the solution on the stack, search_suspended
+    //!         once the budget is spent, search_unsolvable when the search
+    //!         tree is exhausted or the search is stopped.
+    //!
+    //! Running the search again after a solution looks for the next one.
+    SearchStatus search(unsigned long& budget);
 
-    //! \brief Free the cover matrix associated memory.
-    //! \param root A pointer to the root node of the cover matrix.
-    void delete_cover_matrix(Node* root);
+    //! \brief Unselect the rows of the search stack and empty it.
+    void unwind_search();
 
-    //! \brief Solve a sudoku cover matrix.
-    //! \param root A pointer to the root node of the cover matrix.
-    //! \return True if a solution was found, false otherwise.
-    //! \post The solution vector contains the solution nodes.
-    bool solve(Node* root);
+    //! \brief Write the solution on the search stack into a grid.
+    //! \param[out] s A grid holding the predefined values of the search.
+    void write_solution(Sudoku& s) const;
 
     //! \brief Choose the next column to cover.
-    //! \param root A pointer to the root node of the cover matrix.
-    //! \return A pointer to the column header.
-    Node* choose_next_column(Node* root);
+    //! \return The header of a column with the fewest elements, the root
+    //!         (0) if every column is covered.
+    //!
+    //! The buckets are looked at by increasing count: a dead end
+    //! (count 0) or a forced row (count 1) is found in the first words.
+    Index choose_next_column();
 
     //! \brief Cover a column.
-    //! \param header A pointer to the header of the column to be covered.
-    void cover_column(Node* header);
+    //! \param header The header of the column to be covered.
+    void cover_column(Index header);
 
     //! \brief Uncover a column.
-    //! \param header A pointer to the header of the column to be uncovered.
-    void uncover_column(Node* header);
+    //! \param header The header of the column to be uncovered.
+    void uncover_column(Index header);
+
+    //! \brief Take a column out of its bucket.
+    //! \param header The column header.
+    void unlink_bucket(Index header);
+
+    //! \brief Put a column in the bucket of its count.
+    //! \param header The column header.
+    void link_bucket(Index header);
+
+    //! \brief Remove an element from a column count.
+    //! \param header The column header, not covered.
+    void decrement_count(Index header);
+
+    //! \brief Add an element to a column count.
+    //! \param header The column header, not covered.
+    void increment_count(Index header);
+
+    std::map<std::pair<unsigned short, unsigned short>, CoverMatrix> matrices; /**< Cover matrices, by region size. */
+    std::vector<Frame> frames;      /**< Search stack, from the root of the search tree. */
+    bool backtracking;              /**< True if the search resumes by trying the next row of the top frame. */
+    CoverMatrix* searched;          /**< Matrix of the search in progress, null if none. */
+    CoverMatrix* active;            /**< Matrix cover_column and the search work on, the last one built or returned by cover_matrix. */
+    unsigned long long num_nodes;   /**< Nodes visited by the resumable search. */
+    std::vector<unsigned int> selected_rows;    /**< Rows selected while enumerating, as cell index * size + value. */
+    const std::atomic<bool>* stop_flag; /**< Raised to stop the search, may be null. */
+    unsigned int num_allocations;   /**< Heap allocations made by the current solve. */
+    Stats stats;                    /**< Statistics of the current search. */
 };
 
+//! \brief Dancing links solver without statistics.
+typedef BasicDancingLinksSolver<NoStats> DancingLinksSolver;
+
+//! \brief Dancing links solver counting the search events.
+typedef BasicDancingLinksSolver<SearchStats> StatsDancingLinksSolver;
+
 #endif // SUDOKU_SOLVER_H_
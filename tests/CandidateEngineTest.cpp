@@ -0,0 +1,250 @@
+//! \file
+//! \brief CandidateEngine unit tests.
+//! \author Mathieu Turcotte
+
+#include <random>
+#include <vector>
+
+#include "Check.hpp"
+#include "../src/CandidateEngine.hpp"
+
+namespace {
+
+//! \brief Candidates, dead end and hint of a grid, computed from scratch.
+class Reference {
+public:
+    explicit Reference(const Sudoku& s): s(s), size(s.size()) {
+        unsigned int num_cells = size * size;
+        cand.assign(num_cells, 0);
+        for (unsigned int index = 0; index < num_cells; ++index) {
+            if (s.at(index) != Sudoku::empty)
+                continue;
+            uint32_t values = (uint32_t(1) << size) - 1;
+            for (unsigned int other = 0; other < num_cells; ++other) {
+                if (other != index && s.at(other) != Sudoku::empty && peers(index, other))
+                    values &= ~(uint32_t(1) << s.at(other));
+            }
+            cand[index] = values;
+        }
+    }
+
+    //! \brief Check whether a cell belongs to a unit.
+    bool in_unit(unsigned int index, unsigned int unit) const {
+        unsigned int row = index / size, col = index % size;
+        if (unit < size)
+            return row == unit;
+        if (unit < 2 * size)
+            return col == unit - size;
+        unsigned int rows = s.region_num_rows(), cols = s.region_num_columns();
+        return row / rows * rows + col / cols == unit - 2 * size;
+    }
+
+    //! \brief Check whether two cells share a row, column or region.
+    bool peers(unsigned int a, unsigned int b) const {
+        for (unsigned int unit = 0; unit < 3 * size; ++unit) {
+            if (in_unit(a, unit) && in_unit(b, unit))
+                return true;
+        }
+        return false;
+    }
+
+    //! \brief Query whether a unit holds a value.
+    bool holds(unsigned int unit, unsigned int value) const {
+        for (unsigned int index = 0; index < size * size; ++index) {
+            if (in_unit(index, unit) && s.at(index) == value)
+                return true;
+        }
+        return false;
+    }
+
+    //! \brief Get the empty cells of a unit accepting a value.
+    std::vector<unsigned int> places(unsigned int unit, unsigned int value) const {
+        std::vector<unsigned int> cells;
+        for (unsigned int index = 0; index < size * size; ++index) {
+            if (in_unit(index, unit) && (cand[index] & (uint32_t(1) << value)))
+                cells.push_back(index);
+        }
+        return cells;
+    }
+
+    bool find_dead_end(DeadEnd& dead_end) const {
+        for (unsigned int index = 0; index < size * size; ++index) {
+            if (s.at(index) == Sudoku::empty && cand[index] == 0) {
+                dead_end.kind = DeadEnd::no_candidate;
+                dead_end.cell = index;
+                return true;
+            }
+        }
+        for (unsigned int unit = 0; unit < 3 * size; ++unit) {
+            for (unsigned int value = 0; value < size; ++value) {
+                if (!holds(unit, value) && places(unit, value).empty()) {
+                    dead_end.kind = DeadEnd::no_place;
+                    dead_end.unit = unit;
+                    dead_end.value = value;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool find_hint(Hint& hint) const {
+        for (unsigned int index = 0; index < size * size; ++index) {
+            if (cand[index] != 0 && (cand[index] & (cand[index] - 1)) == 0) {
+                hint.cell = index;
+                for (hint.value = 0; !(cand[index] & (uint32_t(1) << hint.value)); ++hint.value) {
+                }
+                hint.hidden = false;
+                return true;
+            }
+        }
+        for (unsigned int unit = 0; unit < 3 * size; ++unit) {
+            for (unsigned int value = 0; value < size; ++value) {
+                std::vector<unsigned int> cells = places(unit, value);
+                if (!holds(unit, value) && cells.size() == 1) {
+                    hint.cell = cells[0];
+                    hint.value = value;
+                    hint.hidden = true;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    const Sudoku& s;            /**< The grid. */
+    unsigned int size;          /**< Grid size. */
+    std::vector<uint32_t> cand; /**< Candidates of each cell, 0 if set. */
+};
+
+//! \brief Check every answer of an engine against the reference.
+void check_engine(const CandidateEngine& engine, const Sudoku& s) {
+    Reference reference(s);
+    unsigned int size = s.size();
+    bool same = true;
+    for (unsigned int index = 0; index < size * size; ++index) {
+        same = same && engine.candidates(index / size, index % size) == reference.cand[index];
+    }
+    CHECK(same);
+
+    DeadEnd expected_dead_end = DeadEnd(), dead_end = DeadEnd();
+    bool dead = reference.find_dead_end(expected_dead_end);
+    CHECK(engine.is_dead_end() == dead);
+    CHECK(engine.find_dead_end(dead_end) == dead);
+    if (dead) {
+        CHECK(dead_end.kind == expected_dead_end.kind);
+        if (dead_end.kind == DeadEnd::no_candidate)
+            CHECK(dead_end.cell == expected_dead_end.cell);
+        else
+            CHECK(dead_end.unit == expected_dead_end.unit &&
+                  dead_end.value == expected_dead_end.value);
+    }
+
+    Hint expected_hint = Hint(), hint = Hint();
+    bool hinted = reference.find_hint(expected_hint);
+    CHECK(engine.find_hint(hint) == hinted);
+    if (hinted)
+        CHECK(hint.cell == expected_hint.cell && hint.value == expected_hint.value &&
+              hint.hidden == expected_hint.hidden);
+}
+
+//! \brief A grid and what the engine should find in it.
+struct GridCase {
+    unsigned short rows;    /**< Region vertical size. */
+    unsigned short cols;    /**< Region horizontal size. */
+    const char* grid;       /**< The grid, see Sudoku::parse. */
+    int dead_end;           /**< Kind of the dead end, -1 if none. */
+    int hint_cell;          /**< Cell of the hint, -1 if none. */
+    int hint_value;         /**< Value of the hint. */
+};
+
+const GridCase grid_cases[] = {
+    // The last cell of the first row can only hold 3.
+    { 2, 2, "012x" "xxxx" "xxxx" "xxxx", -1, 3, 3 },
+    // r1c3 sees 0 and 1 in its row, 2 and 3 in its column.
+    { 2, 2, "01xx" "xxxx" "xx2x" "xx3x", DeadEnd::no_candidate, -1, 0 },
+    // 2x3 regions: r2c3 sees 0 to 4 in its region.
+    { 2, 3, "012xxx" "34xxxx" "xxxxxx" "xxxxxx" "xxxxxx" "xxxxxx", -1, 8, 5 },
+    // 3x2 regions: rows 1 and 2 and column 1 hold 0, and r3c2 is set, so
+    // 0 has no place left in row 3 nor in the first region.
+    { 3, 2, "xx0xxx" "xxxx0x" "x1xxxx" "0xxxxx" "xxxxxx" "xxxxxx", DeadEnd::no_place, -1, 0 },
+    // An empty grid has neither dead end nor hint.
+    { 3, 3, "", -1, -1, 0 },
+};
+
+void test_grids() {
+    for (std::size_t i = 0; i < sizeof(grid_cases) / sizeof(grid_cases[0]); ++i) {
+        const GridCase& test = grid_cases[i];
+        Sudoku s(test.rows, test.cols);
+        std::string repr(test.grid);
+        if (repr.empty())
+            repr.assign(s.size() * s.size(), 'x');
+        CHECK(s.parse(repr.data(), repr.size()) == Sudoku::parse_ok);
+
+        CandidateEngine engine(s);
+        check_engine(engine, s);
+
+        DeadEnd dead_end;
+        CHECK(engine.find_dead_end(dead_end) == (test.dead_end >= 0));
+        if (test.dead_end >= 0)
+            CHECK(dead_end.kind == test.dead_end);
+        Hint hint;
+        bool hinted = engine.find_hint(hint);
+        if (test.hint_cell >= 0)
+            CHECK(hinted && hint.cell == static_cast<unsigned int>(test.hint_cell) &&
+                  hint.value == test.hint_value);
+        else if (test.dead_end < 0)
+            CHECK(!hinted);
+    }
+}
+
+//! \brief Compare the engine with the reference on random edits, which
+//!        also reach conflicting grids and dead ends.
+void test_random_edits() {
+    const unsigned short geometries[][2] = {
+        { 2, 2 }, { 2, 3 }, { 3, 2 }, { 3, 3 }, { 2, 4 }
+    };
+    std::mt19937 random(2);
+
+    for (std::size_t g = 0; g < sizeof(geometries) / sizeof(geometries[0]); ++g) {
+        Sudoku s(geometries[g][0], geometries[g][1]);
+        CandidateEngine engine(s);
+        unsigned int size = s.size();
+        unsigned int num_cells = size * size;
+
+        for (unsigned int edit = 0; edit < 600; ++edit) {
+            // Mostly place candidates and clear cells, so that the grid
+            // goes in and out of dead ends; conflicting values now and then.
+            unsigned int index = random() % num_cells;
+            uint32_t cand = engine.candidates(index / size, index % size);
+            unsigned char value = Sudoku::empty;
+            unsigned int action = random() % 10;
+            if (action < 5 && cand != 0) {
+                do {
+                    value = static_cast<unsigned char>(random() % size);
+                } while (!(cand & (uint32_t(1) << value)));
+            } else if (action == 9) {
+                value = static_cast<unsigned char>(random() % size);
+            }
+            s.set_at(index, value);
+            engine.set(index / size, index % size, value);
+            // Setting a cell to its value changes nothing.
+            engine.set(index / size, index % size, value);
+            check_engine(engine, s);
+
+            // A reset engine agrees with the edited one.
+            if (edit % 100 == 99) {
+                CandidateEngine fresh((Sudoku(2, 2)));
+                fresh.reset(s);
+                check_engine(fresh, s);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void test_candidate_engine() {
+    test_grids();
+    test_random_edits();
+}
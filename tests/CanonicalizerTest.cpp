@@ -0,0 +1,151 @@
+//! \file
+//! \brief Canonicalizer and CachingSolver unit tests.
+//! \author Mathieu Turcotte
+
+#include <vector>
+
+#include "Check.hpp"
+#include "../src/CachingSolver.hpp"
+#include "../src/Canonicalizer.hpp"
+#include "../src/Generator.hpp"
+#include "../src/GridValidator.hpp"
+#include "../src/Random.hpp"
+
+namespace {
+
+//! \brief Draw a transformation of the sudoku symmetries: bands, rows
+//!        within bands, stacks, columns within stacks, values and, for
+//!        square regions, a transposition.
+GridTransform random_transform(const Sudoku& s, Random& random) {
+    unsigned int size = s.size();
+    unsigned int rows = s.region_num_rows();
+    unsigned int cols = s.region_num_columns();
+    std::vector<unsigned int> values, outer, within;
+    GridTransform transform;
+
+    transform.transposed = rows == cols && random.below(2) == 1;
+    transform.rows.resize(size);
+    random.shuffle(outer, cols);
+    for (unsigned int band = 0; band < cols; ++band) {
+        random.shuffle(within, rows);
+        for (unsigned int i = 0; i < rows; ++i)
+            transform.rows[band * rows + i] = outer[band] * rows + within[i];
+    }
+    transform.cols.resize(size);
+    random.shuffle(outer, rows);
+    for (unsigned int stack = 0; stack < rows; ++stack) {
+        random.shuffle(within, cols);
+        for (unsigned int i = 0; i < cols; ++i)
+            transform.cols[stack * cols + i] = outer[stack] * cols + within[i];
+    }
+    random.shuffle(values, size);
+    transform.labels.assign(values.begin(), values.end());
+    return transform;
+}
+
+//! \brief Check whether a grid is a solution of a puzzle.
+bool solves(const Sudoku& solution, const Sudoku& puzzle) {
+    unsigned int num_cells = puzzle.size() * puzzle.size();
+    for (unsigned int i = 0; i < num_cells; ++i) {
+        if (solution.at(i) == Sudoku::empty ||
+                (puzzle.at(i) != Sudoku::empty && puzzle.at(i) != solution.at(i)))
+            return false;
+    }
+    return GridValidator::is_valid(solution);
+}
+
+//! \brief Generate a few puzzles with a unique solution.
+std::vector<Sudoku> make_puzzles(unsigned short rows, unsigned short cols, std::size_t count) {
+    GeneratorOptions options = { rows, cols, 7, 0, symmetry_none, 1 };
+    PuzzleGenerator generator(options);
+    std::vector<Sudoku> puzzles;
+    for (std::size_t i = 0; i < count; ++i)
+        puzzles.push_back(generator.generate(i));
+    return puzzles;
+}
+
+const unsigned short geometries[][2] = { { 2, 2 }, { 2, 3 }, { 3, 2 }, { 3, 3 }, { 4, 4 } };
+const std::size_t num_geometries = sizeof(geometries) / sizeof(geometries[0]);
+
+void test_round_trip() {
+    Random random(1);
+    for (std::size_t g = 0; g < num_geometries; ++g) {
+        std::vector<Sudoku> puzzles = make_puzzles(geometries[g][0], geometries[g][1], 4);
+        for (std::size_t p = 0; p < puzzles.size(); ++p) {
+            Sudoku& puzzle = puzzles[p];
+            for (unsigned int t = 0; t < 10; ++t) {
+                GridTransform transform = random_transform(puzzle, random);
+                Sudoku transformed, reverted;
+                transform.apply(puzzle, transformed);
+                transform.revert(transformed, reverted);
+                CHECK(reverted == puzzle);
+                CHECK(GridValidator::is_valid(transformed));
+            }
+        }
+    }
+}
+
+void test_invariance() {
+    Random random(2);
+    Canonicalizer canonicalizer;
+    for (std::size_t g = 0; g < num_geometries; ++g) {
+        std::vector<Sudoku> puzzles = make_puzzles(geometries[g][0], geometries[g][1], 4);
+        for (std::size_t p = 0; p < puzzles.size(); ++p) {
+            Sudoku& puzzle = puzzles[p];
+            Sudoku canonical, mapped;
+            GridTransform transform;
+            bool kept = canonicalizer.canonicalize(puzzle, canonical, transform);
+            if (kept) {
+                // The transformation given maps the grid to its canonical form.
+                transform.apply(puzzle, mapped);
+                CHECK(mapped == canonical);
+            }
+
+            for (unsigned int t = 0; t < 10; ++t) {
+                Sudoku transformed, other;
+                GridTransform other_transform;
+                random_transform(puzzle, random).apply(puzzle, transformed);
+                // Ties, hence giving up, are invariants too.
+                CHECK(canonicalizer.canonicalize(transformed, other, other_transform) == kept);
+                if (kept) {
+                    CHECK(other == canonical);
+                    CHECK(Canonicalizer::hash(other) == Canonicalizer::hash(canonical));
+                }
+            }
+        }
+    }
+}
+
+void test_caching_solver() {
+    Random random(3);
+    for (std::size_t g = 0; g < num_geometries; ++g) {
+        std::vector<Sudoku> puzzles = make_puzzles(geometries[g][0], geometries[g][1], 4);
+        CachingSolver solver(16);
+        for (std::size_t p = 0; p < puzzles.size(); ++p) {
+            Sudoku solution(puzzles[p]);
+            CHECK(solver.solve(solution) && solves(solution, puzzles[p]));
+
+            for (unsigned int t = 0; t < 5; ++t) {
+                GridTransform transform = random_transform(puzzles[p], random);
+                Sudoku transformed, expected;
+                transform.apply(puzzles[p], transformed);
+                transform.apply(solution, expected);
+                Sudoku answer(transformed);
+                CHECK(solver.solve(answer) && solves(answer, transformed));
+                // The solution is unique, the cache must find that one.
+                CHECK(answer == expected);
+            }
+        }
+        const CacheStats& stats = solver.cache_stats();
+        CHECK(stats.hits + stats.misses + stats.skipped == puzzles.size() * 6);
+        CHECK(stats.hits > 0 && stats.hits == stats.misses * 5);
+    }
+}
+
+} // namespace
+
+void test_canonicalizer() {
+    test_round_trip();
+    test_invariance();
+    test_caching_solver();
+}
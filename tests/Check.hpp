@@ -0,0 +1,34 @@
+//! \file
+//! \brief Unit test helpers.
+//! \author Mathieu Turcotte
+
+#ifndef CHECK_H_
+#define CHECK_H_
+
+//! \brief Record the outcome of a check.
+//! \param condition The checked condition.
+//! \param expression The condition source, reported if it is false.
+//! \param file The source file of the check.
+//! \param line The source line of the check.
+//! \return The condition.
+bool check(bool condition, const char* expression, const char* file, int line);
+
+//! \brief Check a condition, reporting its source and line if it is false.
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+//! \brief Get the number of checks so far.
+unsigned long num_checks();
+
+//! \brief Get the number of failed checks so far.
+unsigned long num_failures();
+
+// Test suites, one per tested class.
+void test_sudoku_parse();
+void test_grid_validator();
+void test_candidate_engine();
+void test_solution_store();
+void test_canonicalizer();
+void test_grid_file();
+void test_generator();
+
+#endif // CHECK_H_
@@ -0,0 +1,113 @@
+//! \file
+//! \brief PuzzleGenerator unit tests.
+//! \author Mathieu Turcotte
+
+#include <vector>
+
+#include "Check.hpp"
+#include "../src/Generator.hpp"
+#include "../src/GridValidator.hpp"
+
+namespace {
+
+//! \brief Get the cell a clue is paired with by a symmetry.
+unsigned int symmetric(unsigned int index, unsigned int size, Symmetry symmetry) {
+    if (symmetry == symmetry_rotational)
+        return size * size - 1 - index;
+    if (symmetry == symmetry_mirror)
+        return index / size * size + size - 1 - index % size;
+    return index;
+}
+
+//! \brief Count the clues of a puzzle.
+unsigned int num_clues(const Sudoku& s) {
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < s.size() * s.size(); ++i)
+        count += s.at(i) != Sudoku::empty;
+    return count;
+}
+
+const unsigned short geometries[][2] = { { 2, 2 }, { 2, 3 }, { 3, 2 }, { 3, 3 } };
+const std::size_t num_geometries = sizeof(geometries) / sizeof(geometries[0]);
+const Symmetry symmetries[] = { symmetry_none, symmetry_rotational, symmetry_mirror };
+
+void test_minimal_puzzles() {
+    DancingLinksSolver solver;
+    for (std::size_t g = 0; g < num_geometries; ++g) {
+        for (std::size_t y = 0; y < 3; ++y) {
+            Symmetry symmetry = symmetries[y];
+            GeneratorOptions options = { geometries[g][0], geometries[g][1], 10, 0, symmetry, 1 };
+            PuzzleGenerator generator(options);
+            for (unsigned int p = 0; p < 5; ++p) {
+                Sudoku puzzle = generator.generate(p);
+                unsigned int size = puzzle.size();
+                CHECK(GridValidator::is_valid(puzzle));
+                CHECK(solver.count_solutions(puzzle, 2) == 1);
+
+                bool symmetric_clues = true, minimal = true, kept = true;
+                for (unsigned int i = 0; i < size * size; ++i) {
+                    unsigned int other = symmetric(i, size, symmetry);
+                    unsigned char value = puzzle.at(i);
+                    symmetric_clues = symmetric_clues &&
+                            (value == Sudoku::empty) == (puzzle.at(other) == Sudoku::empty);
+                    if (value == Sudoku::empty || other < i)
+                        continue;
+                    // A given is in every solution.
+                    kept = kept && !solver.has_solution_without(puzzle, i, value);
+
+                    // Removing a clue, with its symmetric, loses uniqueness.
+                    Sudoku fewer(puzzle);
+                    fewer.set_at(i, Sudoku::empty);
+                    fewer.set_at(other, Sudoku::empty);
+                    minimal = minimal && solver.count_solutions(fewer, 2) == 2;
+                }
+                CHECK(symmetric_clues);
+                CHECK(minimal);
+                CHECK(kept);
+            }
+        }
+    }
+}
+
+void test_clue_target() {
+    DancingLinksSolver solver;
+    for (std::size_t y = 0; y < 3; ++y) {
+        GeneratorOptions options = { 3, 3, 11, 40, symmetries[y], 1 };
+        PuzzleGenerator generator(options);
+        for (unsigned int p = 0; p < 5; ++p) {
+            Sudoku puzzle = generator.generate(p);
+            // Symmetric clues are removed in pairs, one more may be left.
+            CHECK(num_clues(puzzle) == 40 || num_clues(puzzle) == 41);
+            CHECK(solver.count_solutions(puzzle, 2) == 1);
+        }
+    }
+}
+
+void test_threads() {
+    const std::size_t count = 12;
+    for (std::size_t g = 0; g < num_geometries; ++g) {
+        unsigned short rows = geometries[g][0], cols = geometries[g][1];
+        GeneratorOptions options = { rows, cols, 12, 0, symmetry_rotational, 1 };
+        PuzzleGenerator single(options);
+        options.num_threads = 4;
+        PuzzleGenerator multiple(options);
+
+        std::vector<Sudoku> one(count, Sudoku(rows, cols)), four(count, Sudoku(rows, cols));
+        single.generate(5, one.data(), count);
+        multiple.generate(5, four.data(), count);
+        bool same = true;
+        for (std::size_t i = 0; i < count; ++i) {
+            Sudoku alone = single.generate(5 + i);
+            same = same && one[i] == four[i] && alone == one[i];
+        }
+        CHECK(same);
+    }
+}
+
+} // namespace
+
+void test_generator() {
+    test_minimal_puzzles();
+    test_clue_target();
+    test_threads();
+}
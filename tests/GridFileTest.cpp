@@ -0,0 +1,196 @@
+//! \file
+//! \brief GridFile unit tests.
+//! \author Mathieu Turcotte
+
+#include <algorithm>
+#include <cstdio>   // std::remove
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.hpp"
+#include "../src/GridFile.hpp"
+
+namespace {
+
+const char* const grid_path = "sudoku-tests-grids.sdkb";
+const char* const copy_path = "sudoku-tests-copy.sdkb";
+
+//! \brief Draw a grid, about a third of its cells empty.
+Sudoku random_grid(unsigned short rows, unsigned short cols, std::mt19937& random) {
+    Sudoku s(rows, cols);
+    unsigned int size = s.size();
+    for (unsigned int i = 0; i < size * size; ++i)
+        s.set_at(i, random() % 3 == 0 ? Sudoku::empty : static_cast<unsigned char>(random() % size));
+    return s;
+}
+
+//! \brief Check that a view holds the cells of a grid.
+bool same_cells(const GridView& view, const Sudoku& s) {
+    unsigned int size = s.size();
+    if (view.size() != size)
+        return false;
+    for (unsigned int i = 0; i < size * size; ++i) {
+        if (view.at(i) != s.at(i))
+            return false;
+    }
+    Sudoku copy(s.region_num_rows(), s.region_num_columns());
+    view.copy_to(copy);
+    std::string text;
+    view.append_to(text);
+    return copy == s && text == s.getString();
+}
+
+std::string read_file(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_file(const char* path, const std::string& content) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(content.data(), content.size());
+}
+
+//! \brief Check whether opening a grid file fails for the given reason.
+//! \param path The file path.
+//! \param reason Part of the error message, 0 if the file must open.
+bool fails_with(const char* path, const char* reason) {
+    try {
+        GridFile file(path);
+    } catch (const std::runtime_error& e) {
+        return reason && std::string(e.what()).find(reason) != std::string::npos;
+    }
+    return !reason;
+}
+
+void test_packing() {
+    CHECK(GridFile::bits_per_cell(4) == 4 && GridFile::bits_per_cell(9) == 4);
+    CHECK(GridFile::bits_per_cell(15) == 4 && GridFile::bits_per_cell(16) == 5);
+    CHECK(GridFile::bits_per_cell(25) == 5);
+    CHECK(GridFile::packed_size(4) == 8 && GridFile::packed_size(9) == 41);
+    CHECK(GridFile::packed_size(16) == 160 && GridFile::packed_size(25) == 391);
+
+    // Cells from the least significant bits, empty as 0, values plus one.
+    Sudoku s(2, 2);
+    s.set_at(0, 0);
+    s.set_at(1, 1);
+    s.set_at(3, 3);
+    s.set_at(15, 2);
+    unsigned char packed[8];
+    GridFile::pack(s, packed);
+    const unsigned char expected[8] = { 0x21, 0x40, 0, 0, 0, 0, 0, 0x30 };
+    CHECK(std::equal(packed, packed + 8, expected));
+
+    // 5 bits cells straddle bytes: 16 in bits 0-4, 8 in bits 5-9.
+    Sudoku big(4, 4);
+    big.set_at(0, 15);
+    big.set_at(1, 7);
+    unsigned char packed_big[160];
+    GridFile::pack(big, packed_big);
+    CHECK(packed_big[0] == 0x10 && packed_big[1] == 0x01 && packed_big[2] == 0);
+}
+
+void test_round_trip() {
+    const unsigned short geometries[][2] = {
+        { 2, 2 }, { 2, 3 }, { 3, 3 }, { 3, 5 }, { 4, 4 }, { 4, 5 }, { 5, 5 }
+    };
+    std::mt19937 random(8);
+
+    for (std::size_t g = 0; g < sizeof(geometries) / sizeof(geometries[0]); ++g) {
+        unsigned short rows = geometries[g][0], cols = geometries[g][1];
+        for (int with_solutions = 0; with_solutions < 2; ++with_solutions) {
+            std::vector<Sudoku> puzzles, solutions;
+            GridFileWriter writer(grid_path, rows, cols, with_solutions != 0);
+            for (unsigned int i = 0; i < 20; ++i) {
+                puzzles.push_back(random_grid(rows, cols, random));
+                solutions.push_back(random_grid(rows, cols, random));
+                // Every third puzzle is unsolved.
+                writer.write(puzzles[i], i % 3 == 0 ? 0 : &solutions[i]);
+            }
+            writer.close();
+
+            GridFile file(grid_path);
+            CHECK(file.size() == puzzles.size());
+            CHECK(file.region_num_rows() == rows && file.region_num_columns() == cols);
+            CHECK(file.has_solutions() == (with_solutions != 0));
+            bool same = true;
+            for (std::size_t i = 0; i < puzzles.size(); ++i) {
+                same = same && same_cells(file.puzzle(i), puzzles[i]);
+                if (with_solutions)
+                    same = same && (i % 3 == 0 ? file.solution(i).is_empty() :
+                                    same_cells(file.solution(i), solutions[i]));
+            }
+            CHECK(same);
+        }
+    }
+
+    GridFileWriter writer(grid_path, 3, 3, false);
+    writer.close();
+    GridFile file(grid_path);
+    CHECK(file.size() == 0);
+    std::remove(grid_path);
+}
+
+//! \brief A change to a valid grid file.
+struct Corruption {
+    std::size_t offset;     /**< Offset of the changed byte. */
+    unsigned char value;    /**< New value of the byte. */
+    std::size_t length;     /**< Length the file is cut to, 0 to keep it. */
+    const char* reason;     /**< Part of the error message, 0 if it opens. */
+};
+
+void test_corrupt_headers() {
+    std::mt19937 random(9);
+    {
+        GridFileWriter writer(grid_path, 3, 3, true);
+        for (unsigned int i = 0; i < 4; ++i) {
+            Sudoku puzzle = random_grid(3, 3, random);
+            writer.write(puzzle, &puzzle);
+        }
+        writer.close();
+    }
+    const std::string original = read_file(grid_path);
+    CHECK(fails_with(grid_path, 0));
+
+    const char* const header = "not a grid file";
+    const char* const geometry = "unsupported geometry";
+    const char* const truncated = "truncated grid file";
+    const Corruption cases[] = {
+        { 0, 'X', 0, header },                      // magic
+        { 4, 2, 0, header },                        // version
+        { 5, 0, 0, geometry },
+        { 6, 6, 0, geometry },
+        { 8, 5, 0, truncated },                     // more records than written
+        { 15, 1, 0, truncated },                    // huge record count
+        { 7, 0, 0, 0 },                             // records without solutions fit
+        { 0, 'S', 1, header },                      // cut header
+        { 0, 'S', GridFile::header_size - 1, header },
+        { 0, 'S', original.size() - 1, truncated }, // cut record
+    };
+    for (std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        std::string content = original;
+        content[cases[i].offset] = static_cast<char>(cases[i].value);
+        if (cases[i].length)
+            content.resize(cases[i].length);
+        // Leave room for the records of the largest grids, so that only
+        // the geometry can be blamed.
+        if (cases[i].reason == geometry)
+            content.resize(content.size() + 4 * 2 * GridFile::packed_size(36));
+        write_file(copy_path, content);
+        CHECK(fails_with(copy_path, cases[i].reason));
+    }
+    write_file(copy_path, std::string());
+    CHECK(fails_with(copy_path, "cannot map"));
+    std::remove(copy_path);
+    CHECK(fails_with(copy_path, "cannot open"));
+    std::remove(grid_path);
+}
+
+} // namespace
+
+void test_grid_file() {
+    test_packing();
+    test_round_trip();
+    test_corrupt_headers();
+}
@@ -0,0 +1,170 @@
+//! \file
+//! \brief GridValidator unit tests.
+//! \author Mathieu Turcotte
+
+#include <random>
+#include <vector>
+
+#include "Check.hpp"
+#include "../src/GridValidator.hpp"
+
+namespace {
+
+//! \brief Two cells given the same value, and whether they conflict.
+struct PairCase {
+    unsigned short rows;    /**< Region vertical size. */
+    unsigned short cols;    /**< Region horizontal size. */
+    unsigned short r1, c1;  /**< First cell. */
+    unsigned short r2, c2;  /**< Second cell, after the first. */
+    bool conflict;          /**< True if the cells share a unit. */
+};
+
+// Cells on either side of the region borders, where the region
+// arithmetic of non-square regions goes wrong first.
+const PairCase pair_cases[] = {
+    { 2, 3,  0, 0,  1, 2, true },   // same region
+    { 2, 3,  0, 2,  1, 3, false },  // across a vertical region border
+    { 2, 3,  1, 1,  2, 2, false },  // across a horizontal region border
+    { 2, 3,  1, 0,  2, 0, true },   // same column
+    { 2, 3,  2, 3,  3, 5, true },   // region 3
+    { 2, 3,  4, 0,  5, 2, true },   // region 4
+    { 2, 3,  3, 2,  4, 3, false },
+    { 3, 2,  0, 0,  2, 1, true },
+    { 3, 2,  0, 1,  1, 2, false },
+    { 3, 2,  2, 0,  3, 1, false },
+    { 3, 2,  3, 4,  5, 5, true },   // last region
+    { 3, 2,  4, 2,  4, 5, true },   // same row
+    { 3, 3,  0, 0,  2, 2, true },
+    { 3, 3,  2, 2,  3, 3, false },
+    { 4, 5,  0, 0,  3, 4, true },
+    { 4, 5,  3, 4,  4, 4, true },   // same column
+    { 4, 5,  3, 4,  4, 5, false },
+    { 4, 5,  0, 4,  1, 5, false },
+    { 4, 5,  4, 15, 7, 19, true },
+    { 4, 5, 16, 10, 19, 14, true },
+    { 4, 5, 15, 9, 16, 10, false },
+    { 5, 4,  0, 0,  4, 3, true },
+    { 5, 4,  4, 3,  5, 4, false },
+    { 5, 4, 15, 16, 19, 19, true },
+    { 5, 4, 10, 3, 14, 4, false },
+};
+
+//! \brief Check whether two cells share a row, column or region, the
+//!        slow way.
+bool are_peers(const Sudoku& s, unsigned int a, unsigned int b) {
+    unsigned int size = s.size();
+    unsigned int r1 = a / size, c1 = a % size, r2 = b / size, c2 = b % size;
+    return r1 == r2 || c1 == c2 ||
+            (r1 / s.region_num_rows() == r2 / s.region_num_rows() &&
+             c1 / s.region_num_columns() == c2 / s.region_num_columns());
+}
+
+//! \brief Check whether a cell conflicts with another one, the slow way.
+bool conflicts(const Sudoku& s, unsigned int index) {
+    unsigned int num_cells = s.size() * s.size();
+    if (s.at(index) == Sudoku::empty)
+        return false;
+    for (unsigned int other = 0; other < num_cells; ++other) {
+        if (other != index && s.at(other) == s.at(index) && are_peers(s, index, other))
+            return true;
+    }
+    return false;
+}
+
+void test_pairs() {
+    for (std::size_t i = 0; i < sizeof(pair_cases) / sizeof(pair_cases[0]); ++i) {
+        const PairCase& test = pair_cases[i];
+        Sudoku s(test.rows, test.cols);
+        unsigned int size = s.size();
+        unsigned int first = test.r1 * size + test.c1;
+        unsigned int second = test.r2 * size + test.c2;
+        s.set_at(first, 1);
+        s.set_at(second, 1);
+
+        GridConflict conflict = { 0, 0 };
+        CHECK(GridValidator::is_valid(s, &conflict) == !test.conflict);
+        if (test.conflict)
+            CHECK(conflict.first == first && conflict.second == second);
+
+        std::vector<unsigned int> cells;
+        CHECK(GridValidator::find_conflicts(s, cells) == (test.conflict ? 2u : 0u));
+        if (test.conflict)
+            CHECK(cells[0] == first && cells[1] == second);
+
+        // The same grid, built one cell at a time.
+        GridValidator validator((Sudoku(test.rows, test.cols)));
+        validator.set(test.r1, test.c1, 1);
+        CHECK(validator.is_legal(test.r2, test.c2, 1) == !test.conflict);
+        CHECK(validator.is_legal(test.r2, test.c2, 2));
+        validator.set(test.r2, test.c2, 1);
+        CHECK(validator.conflicting(test.r1, test.c1) == test.conflict);
+        CHECK(validator.conflicting(test.r2, test.c2) == test.conflict);
+        validator.set(test.r1, test.c1, Sudoku::empty);
+        CHECK(!validator.conflicting(test.r2, test.c2));
+        CHECK(validator.is_legal(test.r1, test.c1, 1) == !test.conflict);
+    }
+}
+
+//! \brief Compare the validator with the slow checks on random edits.
+void test_random_edits() {
+    const unsigned short geometries[][2] = {
+        { 2, 2 }, { 2, 3 }, { 3, 2 }, { 3, 3 }, { 4, 5 }, { 5, 4 }, { 5, 5 }
+    };
+    std::mt19937 random(1);
+
+    for (std::size_t g = 0; g < sizeof(geometries) / sizeof(geometries[0]); ++g) {
+        Sudoku s(geometries[g][0], geometries[g][1]);
+        GridValidator validator(s);
+        unsigned int size = s.size();
+        unsigned int num_cells = size * size;
+
+        for (unsigned int edit = 0; edit < 2000; ++edit) {
+            unsigned int index = random() % num_cells;
+            // Clear a cell now and then, so that the grid stays sparse.
+            unsigned char value = random() % 3 == 0 ?
+                    Sudoku::empty : static_cast<unsigned char>(random() % size);
+            s.set_at(index, value);
+            validator.set(index / size, index % size, value);
+
+            // The whole grid is slow to check the slow way.
+            if (edit % 20 == 0) {
+                std::vector<unsigned int> expected;
+                for (unsigned int i = 0; i < num_cells; ++i) {
+                    if (conflicts(s, i))
+                        expected.push_back(i);
+                }
+                std::vector<unsigned int> cells;
+                GridValidator::find_conflicts(s, cells);
+                CHECK(GridValidator::is_valid(s) == expected.empty());
+                CHECK(cells == expected);
+            }
+
+            unsigned int probe = random() % num_cells;
+            CHECK(validator.conflicting(probe / size, probe % size) == conflicts(s, probe));
+            unsigned char saved = s.at(probe);
+            unsigned char candidate = static_cast<unsigned char>(random() % size);
+            s.set_at(probe, candidate);
+            bool legal = !conflicts(s, probe);
+            s.set_at(probe, saved);
+            CHECK(validator.is_legal(probe / size, probe % size, candidate) == legal);
+        }
+    }
+}
+
+void test_describe() {
+    Sudoku s(4, 4);
+    s.set_at(0, 12);
+    s.set_at(3 * 16 + 2, 12);
+    GridConflict conflict;
+    CHECK(!GridValidator::is_valid(s, &conflict));
+    CHECK(GridValidator::describe(s, conflict) ==
+          "conflicting givens: r1c1 and r4c3 both hold C");
+}
+
+} // namespace
+
+void test_grid_validator() {
+    test_pairs();
+    test_random_edits();
+    test_describe();
+}
@@ -0,0 +1,294 @@
+//! \file
+//! \brief SolutionStore unit tests.
+//! \author Mathieu Turcotte
+
+#include <atomic>
+#include <cstdio>   // std::remove
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.hpp"
+#include "../src/GridValidator.hpp"
+#include "../src/SolutionStore.hpp"
+
+namespace {
+
+const char* const store_path = "sudoku-tests-store.db";
+const char* const copy_path = "sudoku-tests-copy.db";
+
+//! \brief Build a distinct 9x9 puzzle for each number below 9^4.
+Sudoku make_puzzle(unsigned int i) {
+    Sudoku s(3, 3);
+    for (unsigned int j = 0; j < 4; ++j, i /= 9)
+        s.set_at(j * 20, static_cast<unsigned char>(i % 9));
+    return s;
+}
+
+//! \brief Build the grid stored as the solution of a puzzle. The store
+//!        doesn't check solutions, any full grid will do.
+Sudoku make_solution(unsigned int i) {
+    Sudoku s(3, 3);
+    for (unsigned int index = 0; index < 81; ++index)
+        s.set_at(index, static_cast<unsigned char>((index + i) % 9));
+    return s;
+}
+
+SolveInfo make_info(unsigned int i) {
+    SolveInfo info = { true, 1000ULL * i, 2ULL * i };
+    return info;
+}
+
+//! \brief Check that a store holds a puzzle with its solution.
+bool holds(const SolutionStore& store, unsigned int i) {
+    Sudoku solution(3, 3);
+    SolveInfo info = { false, 0, 0 };
+    Sudoku expected = make_solution(i);
+    return store.find(make_puzzle(i), &solution, &info) && info.solved &&
+            info.nanoseconds == 1000ULL * i && info.nodes == 2ULL * i &&
+            solution == expected;
+}
+
+std::string read_file(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_file(const char* path, const std::string& content) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(content.data(), content.size());
+}
+
+//! \brief Check whether opening a store throws a runtime_error.
+bool is_rejected(const char* path) {
+    try {
+        SolutionStore store(path);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+void test_create_and_reopen() {
+    std::remove(store_path);
+    CHECK(SolutionStore::create(store_path, 3, 3, 100));
+    // The existing store is left as is.
+    CHECK(!SolutionStore::create(store_path, 2, 2, 10));
+    {
+        SolutionStore store(store_path);
+        CHECK(store.region_num_rows() == 3 && store.region_num_columns() == 3);
+        CHECK(store.capacity() == 100);
+        CHECK(store.size() == 0);
+        CHECK(!store.find(make_puzzle(1), 0, 0));
+
+        for (unsigned int i = 0; i < 10; ++i) {
+            Sudoku solution = make_solution(i);
+            CHECK(store.insert(make_puzzle(i), &solution, make_info(i)) ==
+                  SolutionStore::insert_added);
+        }
+        Sudoku solution = make_solution(3);
+        CHECK(store.insert(make_puzzle(3), &solution, make_info(3)) ==
+              SolutionStore::insert_present);
+        SolveInfo unsolved = { false, 5, 7 };
+        CHECK(store.insert(make_puzzle(10), 0, unsolved) == SolutionStore::insert_added);
+        CHECK(store.insert(Sudoku(2, 2), 0, unsolved) == SolutionStore::insert_mismatch);
+        CHECK(store.size() == 11);
+    }
+
+    SolutionStore store(store_path);
+    CHECK(store.size() == 11);
+    bool found = true;
+    for (unsigned int i = 0; i < 10; ++i)
+        found = found && holds(store, i);
+    CHECK(found);
+
+    // An unsolvable puzzle is found, without solution.
+    Sudoku puzzle = make_puzzle(10);
+    Sudoku untouched = puzzle;
+    SolveInfo info = { true, 0, 0 };
+    CHECK(store.find(puzzle, &puzzle, &info));
+    CHECK(!info.solved && info.nanoseconds == 5 && info.nodes == 7);
+    CHECK(puzzle == untouched);
+
+    CHECK(!store.find(make_puzzle(11), 0, 0));
+    CHECK(!store.find(Sudoku(2, 2), 0, 0));
+    std::remove(store_path);
+}
+
+void test_invalid_create() {
+    const unsigned short cases[][2] = { { 0, 3 }, { 3, 0 }, { 6, 3 }, { 3, 6 } };
+    std::remove(store_path);
+    for (std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        bool thrown = false;
+        try {
+            SolutionStore::create(store_path, cases[i][0], cases[i][1], 10);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+    bool thrown = false;
+    try {
+        SolutionStore::create(store_path, 3, 3, 0);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(is_rejected(store_path));
+}
+
+//! \brief A change to a valid store file.
+struct Corruption {
+    std::size_t offset;     /**< Offset of the changed byte. */
+    unsigned char value;    /**< New value of the byte. */
+    std::size_t length;     /**< Length the file is cut to, 0 to keep it. */
+};
+
+void test_corrupt_headers() {
+    std::remove(store_path);
+    SolutionStore::create(store_path, 3, 3, 16);
+    const std::string original = read_file(store_path);
+    CHECK(!is_rejected(store_path));
+
+    const Corruption cases[] = {
+        { 0, 'X', 0 },                                      // magic
+        { 4, 2, 0 },                                        // version
+        { 5, 0, 0 },                                        // geometry
+        { 6, 6, 0 },
+        { 8, 0xFF, 0 },                                     // byte order mark
+        { 16, 48, 0 },                                      // slots, not a power of two
+        { 16, 8, 0 },                                       // fewer slots than records
+        { 24, 64, 0 },                                      // more records than slots
+        { 0, 'S', 1 },                                      // empty header
+        { 0, 'S', SolutionStore::header_size - 1 },         // cut header
+        { 0, 'S', SolutionStore::header_size + 100 },       // cut index
+        { 0, 'S', original.size() - 1 },                    // cut records
+    };
+    for (std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        std::string content = original;
+        content[cases[i].offset] = static_cast<char>(cases[i].value);
+        if (cases[i].length)
+            content.resize(cases[i].length);
+        write_file(copy_path, content);
+        CHECK(is_rejected(copy_path));
+    }
+    write_file(copy_path, std::string());
+    CHECK(is_rejected(copy_path));
+    std::remove(copy_path);
+    CHECK(is_rejected(copy_path));
+    std::remove(store_path);
+}
+
+void test_full() {
+    std::remove(store_path);
+    SolutionStore::create(store_path, 3, 3, 4);
+    SolutionStore store(store_path);
+    for (unsigned int i = 0; i < 4; ++i) {
+        Sudoku solution = make_solution(i);
+        CHECK(store.insert(make_puzzle(i), &solution, make_info(i)) ==
+              SolutionStore::insert_added);
+    }
+    for (unsigned int i = 4; i < 6; ++i) {
+        Sudoku solution = make_solution(i);
+        CHECK(store.insert(make_puzzle(i), &solution, make_info(i)) ==
+              SolutionStore::insert_full);
+        CHECK(!store.find(make_puzzle(i), 0, 0));
+    }
+    Sudoku solution = make_solution(2);
+    CHECK(store.insert(make_puzzle(2), &solution, make_info(2)) ==
+          SolutionStore::insert_present);
+    CHECK(store.size() == 4);
+    CHECK(holds(store, 0) && holds(store, 3));
+    std::remove(store_path);
+}
+
+//! \brief Insert a range of puzzles through a mapping of its own, once
+//!        every writer is started.
+void write_range(const std::atomic<bool>* start, unsigned int first, unsigned int last,
+                 unsigned int* num_added, unsigned int* num_lost) {
+    SolutionStore store(store_path);
+    while (!start->load())
+        std::this_thread::yield();
+    for (unsigned int i = first; i < last; ++i) {
+        Sudoku solution = make_solution(i);
+        SolutionStore::InsertStatus status = store.insert(make_puzzle(i), &solution, make_info(i));
+        if (status == SolutionStore::insert_added)
+            ++*num_added;
+        // Whoever added it, the puzzle is visible once insert returns.
+        if (status == SolutionStore::insert_full || !holds(store, i))
+            ++*num_lost;
+    }
+}
+
+void test_racing_writers() {
+    const unsigned int num_writers = 4, range = 1000, step = 500, capacity = 4096;
+    const unsigned int num_puzzles = (num_writers - 1) * step + range;
+
+    // Two writers rarely collide in a single pass: race over fresh stores.
+    for (unsigned int round = 0; round < 50; ++round) {
+        std::remove(store_path);
+        SolutionStore::create(store_path, 3, 3, capacity);
+
+        // Each writer shares half of its puzzles with the next one.
+        std::atomic<bool> start(false);
+        std::vector<unsigned int> added(num_writers, 0), lost(num_writers, 0);
+        std::vector<std::thread> writers;
+        for (unsigned int w = 0; w < num_writers; ++w)
+            writers.push_back(std::thread(write_range, &start, w * step, w * step + range,
+                                          &added[w], &lost[w]));
+        start = true;
+        for (unsigned int w = 0; w < num_writers; ++w)
+            writers[w].join();
+
+        unsigned int total_added = 0, total_lost = 0;
+        for (unsigned int w = 0; w < num_writers; ++w) {
+            total_added += added[w];
+            total_lost += lost[w];
+        }
+        // Each puzzle gets in the index once, a few may have two records.
+        CHECK(total_lost == 0);
+        CHECK(total_added == num_puzzles);
+
+        SolutionStore store(store_path);
+        CHECK(store.size() >= num_puzzles && store.size() <= capacity);
+        bool found = true;
+        for (unsigned int i = 0; i < num_puzzles; ++i)
+            found = found && holds(store, i);
+        CHECK(found);
+    }
+    std::remove(store_path);
+}
+
+void test_store_solver() {
+    std::remove(store_path);
+    SolutionStore::create(store_path, 2, 2, 16);
+    SolutionStore store(store_path);
+    StoreSolver solver(store, SudokuSolver::create("dlx-stats"));
+
+    const char repr[] = "0xxx" "xx1x" "x2xx" "xxx3";
+    Sudoku first(2, 2), second(2, 2);
+    first.parse(repr, 16);
+    second.parse(repr, 16);
+    CHECK(solver.solve(first));
+    CHECK(solver.solve(second));
+    CHECK(first == second && GridValidator::is_valid(second));
+    CHECK(solver.num_added() == 1 && solver.num_found() == 1);
+
+    // Grids of another geometry are only solved.
+    Sudoku other(3, 3);
+    CHECK(solver.solve(other));
+    CHECK(solver.num_skipped() == 1 && store.size() == 1);
+    std::remove(store_path);
+}
+
+} // namespace
+
+void test_solution_store() {
+    test_create_and_reopen();
+    test_invalid_create();
+    test_corrupt_headers();
+    test_full();
+    test_racing_writers();
+    test_store_solver();
+}
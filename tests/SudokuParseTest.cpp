@@ -0,0 +1,179 @@
+//! \file
+//! \brief Sudoku::parse unit tests.
+//! \author Mathieu Turcotte
+//!
+//! 9x9 grids are parsed 16 characters at a time where SSE2 is available
+//! (blocks at offsets 0, 16, 32, 48, 64 and 65), other sizes one
+//! character at a time. Both are checked against a plain reading of the
+//! representation rules.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.hpp"
+#include "../src/Sudoku.hpp"
+
+namespace {
+
+//! \brief Value of a character, the slow way.
+//! \return The value, Sudoku::empty for a blank, -1 for anything else.
+int reference_value(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'w')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'W')
+        return c - 'A' + 10;
+    if (c == 'x' || c == 'X' || c == '.' || c == ' ')
+        return Sudoku::empty;
+    return -1;
+}
+
+//! \brief Parse a representation, the slow way.
+Sudoku::ParseStatus reference_parse(const std::string& repr, unsigned int size,
+                                    std::vector<unsigned char>& cells) {
+    cells.assign(size * size, Sudoku::empty);
+    if (repr.size() != size * size)
+        return Sudoku::parse_size_mismatch;
+    for (std::size_t i = 0; i < repr.size(); ++i) {
+        int value = reference_value(repr[i]);
+        if (value < 0 || (value != Sudoku::empty && value >= static_cast<int>(size))) {
+            cells.assign(size * size, Sudoku::empty);
+            return value < 0 ? Sudoku::parse_invalid_character : Sudoku::parse_value_out_of_range;
+        }
+        cells[i] = static_cast<unsigned char>(value);
+    }
+    return Sudoku::parse_ok;
+}
+
+//! \brief Parse a representation over a grid holding values, and compare
+//!        the status and the cells with the slow way.
+bool parses_as_reference(unsigned short rows, unsigned short cols, const std::string& repr) {
+    Sudoku s(rows, cols);
+    unsigned int size = s.size();
+    for (unsigned int i = 0; i < size * size; ++i)
+        s.set_at(i, static_cast<unsigned char>(i % size));
+
+    std::vector<unsigned char> expected;
+    Sudoku::ParseStatus status = reference_parse(repr, size, expected);
+    return s.parse(repr.data(), repr.size()) == status &&
+            std::vector<unsigned char>(s.data(), s.data() + size * size) == expected;
+}
+
+//! \brief Draw a valid representation.
+//! \param size The grid size.
+//! \param random The random generator.
+//! \param blanks The blank characters to use, 4 at most.
+//!
+//! A failed 9x9 block is parsed again one character at a time, so a probe
+//! only reaches the fast path if the rest of its block is accepted there.
+std::string random_repr(unsigned int size, std::mt19937& random, const char* blanks = "xX. ") {
+    std::string repr(size * size, 'x');
+    std::size_t num_blanks = std::char_traits<char>::length(blanks);
+    for (std::size_t i = 0; i < repr.size(); ++i) {
+        unsigned int value = random() % (size + num_blanks);
+        if (value >= size)
+            repr[i] = blanks[value - size];
+        else if (value < 10)
+            repr[i] = static_cast<char>('0' + value);
+        else
+            repr[i] = static_cast<char>((random() % 2 ? 'a' : 'A') + value - 10);
+    }
+    return repr;
+}
+
+const unsigned short geometries[][2] = { { 2, 2 }, { 3, 3 }, { 4, 4 }, { 5, 5 } };
+const std::size_t num_geometries = sizeof(geometries) / sizeof(geometries[0]);
+
+void test_valid() {
+    std::mt19937 random(4);
+    for (std::size_t g = 0; g < num_geometries; ++g) {
+        unsigned int size = geometries[g][0] * geometries[g][1];
+        bool same = true;
+        for (unsigned int i = 0; i < 200; ++i)
+            same = same && parses_as_reference(geometries[g][0], geometries[g][1],
+                                               random_repr(size, random));
+        CHECK(same);
+    }
+}
+
+void test_every_character() {
+    // Both ends and the edges of every 9x9 block, the last cell included.
+    const unsigned int positions[] = { 0, 1, 15, 16, 17, 31, 32, 47, 48, 63, 64, 65, 66, 79, 80 };
+    std::mt19937 random(5);
+    for (std::size_t g = 0; g < num_geometries; ++g) {
+        unsigned int size = geometries[g][0] * geometries[g][1];
+        for (std::size_t p = 0; p < sizeof(positions) / sizeof(positions[0]); ++p) {
+            if (positions[p] >= size * size)
+                continue;
+            std::string repr = random_repr(size, random, "xX");
+            bool same = true;
+            for (unsigned int c = 0; c < 256; ++c) {
+                repr[positions[p]] = static_cast<char>(c);
+                same = same && parses_as_reference(geometries[g][0], geometries[g][1], repr);
+            }
+            CHECK(same);
+        }
+    }
+}
+
+void test_bad_character_anywhere() {
+    // A value out of range, and characters just around the digits and
+    // the blanks, at every cell of a 9x9 grid.
+    const char bad[] = { '9', 'a', 'O', '/', ':', 'w', 'y', '-', '\0', '\x80' };
+    std::mt19937 random(6);
+    for (unsigned int position = 0; position < 81; ++position) {
+        std::string repr = random_repr(9, random, "x");
+        bool same = true;
+        for (std::size_t b = 0; b < sizeof(bad); ++b) {
+            repr[position] = bad[b];
+            same = same && parses_as_reference(3, 3, repr);
+        }
+        CHECK(same);
+    }
+}
+
+void test_sizes() {
+    std::mt19937 random(7);
+    for (std::size_t g = 0; g < num_geometries; ++g) {
+        unsigned int size = geometries[g][0] * geometries[g][1];
+        std::string repr = random_repr(size, random);
+        CHECK(parses_as_reference(geometries[g][0], geometries[g][1], ""));
+        CHECK(parses_as_reference(geometries[g][0], geometries[g][1], repr.substr(1)));
+        CHECK(parses_as_reference(geometries[g][0], geometries[g][1], repr + "x"));
+        CHECK(parses_as_reference(geometries[g][0], geometries[g][1], repr + repr));
+    }
+}
+
+void test_domains() {
+    Sudoku s16(4, 4), s25(5, 5);
+    std::string repr(256, 'x');
+    repr[0] = 'F';
+    repr[1] = 'f';
+    CHECK(s16.parse(repr.data(), repr.size()) == Sudoku::parse_ok);
+    CHECK(s16.at(0) == 15 && s16.at(1) == 15 && s16.at(2) == Sudoku::empty);
+    repr[1] = 'G';
+    CHECK(s16.parse(repr.data(), repr.size()) == Sudoku::parse_value_out_of_range);
+
+    repr.assign(625, '.');
+    repr[624] = 'O';
+    repr[623] = 'o';
+    CHECK(s25.parse(repr.data(), repr.size()) == Sudoku::parse_ok);
+    CHECK(s25.at(624) == 24 && s25.at(623) == 24);
+    repr[0] = 'P';
+    CHECK(s25.parse(repr.data(), repr.size()) == Sudoku::parse_value_out_of_range);
+    CHECK(s25.at(624) == Sudoku::empty);
+    repr[0] = 'y';
+    CHECK(s25.parse(repr.data(), repr.size()) == Sudoku::parse_invalid_character);
+}
+
+} // namespace
+
+void test_sudoku_parse() {
+    test_valid();
+    test_every_character();
+    test_bad_character_anywhere();
+    test_sizes();
+    test_domains();
+}
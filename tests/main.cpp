@@ -0,0 +1,47 @@
+//! \file
+//! \brief Unit tests.
+//! \author Mathieu Turcotte
+//!
+//! Runs every test suite, reports each failed check on the standard error
+//! and exits with status 1 if any failed.
+
+#include <iostream>
+
+#include "Check.hpp"
+
+namespace {
+
+unsigned long checks = 0;
+unsigned long failures = 0;
+
+} // namespace
+
+bool check(bool condition, const char* expression, const char* file, int line) {
+    checks++;
+    if (!condition) {
+        failures++;
+        std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+    }
+    return condition;
+}
+
+unsigned long num_checks() {
+    return checks;
+}
+
+unsigned long num_failures() {
+    return failures;
+}
+
+int main() {
+    test_sudoku_parse();
+    test_grid_validator();
+    test_candidate_engine();
+    test_solution_store();
+    test_canonicalizer();
+    test_grid_file();
+    test_generator();
+
+    std::cerr << num_checks() << " checks, " << num_failures() << " failed" << std::endl;
+    return num_failures() ? 1 : 0;
+}